@@ -55,6 +55,8 @@ void setup()
   // you can use also
   //rtc.setTime(hours, minutes, seconds);
   //rtc.setDate(weekDay, day, month, year);
+  // or, in a single RTC update
+  //rtc.edit().hours(hours).minutes(minutes).seconds(seconds).weekDay(weekDay).day(day).month(month).year(year).commit();
 }
 
 void loop()
@@ -36,7 +36,59 @@
 #include "STM32RTC.h"
 
 #define EPOCH_TIME_OFF      946684800  // This is 1st January 2000, 00:00:00 in epoch time
-#define EPOCH_TIME_YEAR_OFF 100        // years since 1900
+#define SECONDS_PER_DAY     86400
+#define EPOCH_TIME_MAX      4102444799 // This is 31st December 2099, 23:59:59 in epoch time
+#define DRIFT_STATE_MARKER  0xD5       // Drift learning state saved in the backup registers
+
+/* Limits of the drift learning from the setEpoch() corrections */
+static constexpr driftLimits_t driftLimits = {
+  STM32RTC_DRIFT_MIN_INTERVAL, STM32RTC_DRIFT_OUTLIER_PPB, STM32RTC_DRIFT_MAX_OUTLIERS, STM32RTC_DRIFT_WINDOW
+};
+
+/**
+  * @brief  convert a calendar date and time into epoch time (UTC)
+  * @param  year: 0-99
+  * @param  month: 1-12
+  * @param  day: 1-31
+  * @param  hours: 0-23
+  * @param  minutes: 0-59
+  * @param  seconds: 0-59
+  * @retval epoch time in seconds
+  */
+static constexpr time_t epochFromCivil(uint8_t year, uint8_t month, uint8_t day,
+                                       uint8_t hours, uint8_t minutes, uint8_t seconds)
+{
+  return EPOCH_TIME_OFF + ((time_t)RTC_DaysFromCivil(year, month, day) * SECONDS_PER_DAY)
+         + ((time_t)hours * 3600) + ((time_t)minutes * 60) + seconds;
+}
+
+/**
+  * @brief  convert an epoch time (UTC) into calendar date and time
+  * @note   Reentrant: no static buffer nor allocation (unlike gmtime()).
+  *         Epoch time is saturated to the RTC range (2000-2099).
+  * @param  ts: epoch time in seconds
+  * @param  dateTime: pointer where to store the date and the time (hours: 0-23),
+  *         subSeconds and period are not updated.
+  * @retval None
+  */
+static void civilFromEpoch(time_t ts, dateTime_t *dateTime)
+{
+  civilTime_t civil;
+
+  if (ts < EPOCH_TIME_OFF) {
+    ts = EPOCH_TIME_OFF;
+  } else if (ts > EPOCH_TIME_MAX) {
+    ts = EPOCH_TIME_MAX;
+  }
+  civil = RTC_CivilFromY2k((uint32_t)(ts - EPOCH_TIME_OFF));
+  dateTime->year = civil.year;
+  dateTime->month = civil.month;
+  dateTime->day = civil.day;
+  dateTime->wday = civil.wday;
+  dateTime->hours = civil.hours;
+  dateTime->minutes = civil.minutes;
+  dateTime->seconds = civil.seconds;
+}
 
 // Initialize static variable
 bool STM32RTC::_timeSet = false;
@@ -77,38 +129,11 @@ void STM32RTC::begin(bool resetTime, Hour_Format format)
 #endif /* RCC_RTC_WDG_BLEWKUP_CLKSOURCE_HSI64M_DIV2048 || RCC_RTC_WDG_SUBG_LPAWUR_LCD_LCSC_CLKSOURCE_DIV512 */
   _timeSet = !reinit;
 
-  syncDate();
-  syncTime();
-
-  /* fix race condition where date may have changed between reading date and time */
-  if (_seconds == 0 && _minutes == 0 && _hours == 0) {
-    syncDate();
-  }
+  calendarChanged();
+  syncDateTime();
 
-  syncAlarmTime();
-  if (!IS_RTC_DATE(_alarmDay)) {
-    // Use current time to init alarm members,
-    // specially in case _alarmDay is 0 (reset value) which is an invalid value
-    _alarmDay  = _day;
-    _alarmHours = _hours;
-    _alarmMinutes = _minutes;
-    _alarmSeconds = _seconds;
-    _alarmSubSeconds = _subSeconds;
-    _alarmPeriod = _hoursPeriod;
-  }
-#ifdef RTC_ALARM_B
-  syncAlarmTime(ALARM_B);
-  if (!IS_RTC_DATE(_alarmBDay)) {
-    // Use current time to init alarm members,
-    // specially in case _alarmDay is 0 (reset value) which is an invalid value
-    _alarmBDay  = _day;
-    _alarmBHours = _hours;
-    _alarmBMinutes = _minutes;
-    _alarmBSeconds = _seconds;
-    _alarmBSubSeconds = _subSeconds;
-    _alarmBPeriod = _hoursPeriod;
-  }
-#endif
+  // Alarms are loaded on first use, keep only the ones with pending values
+  _alarmValid &= _alarmDirty;
 }
 
 /**
@@ -215,6 +240,269 @@ void STM32RTC::setPrediv(uint32_t predivA, uint32_t predivS)
   setClockSource(_clockSource, predivA, predivS);
 }
 
+/**
+  * @brief  set the prescalers giving the nearest SubSecond resolution with a
+  *         1Hz calendar clock, for the current clock source. A finer
+  *         resolution increases the RTC power consumption.
+  * @note   Can be called before begin() or, in BCD mode, after it: the
+  *         current time is kept.
+  * @param  ticksPerSecond: requested nb of SubSecond ticks per second
+  * @retval achieved nb of ticks per second, 0 if not set
+  */
+uint32_t STM32RTC::setSubsecondResolution(uint32_t ticksPerSecond)
+{
+#if defined(STM32F1xx)
+  UNUSED(ticksPerSecond);
+  return 0;
+#else
+  uint32_t ticks = RTC_SetSubSecondResolution(ticksPerSecond);
+  if ((ticks != 0) && isConfigured()) {
+    calendarChanged();
+  }
+  return ticks;
+#endif /* STM32F1xx */
+}
+
+/**
+  * @brief  set the prescalers from a power profile, see setSubsecondResolution()
+  * @param  profile: LOWEST_POWER, BALANCED (about 1ms resolution) or FINEST_RESOLUTION
+  * @retval achieved nb of ticks per second, 0 if not set
+  */
+uint32_t STM32RTC::setPowerProfile(PowerProfile profile)
+{
+  switch (profile) {
+    case LOWEST_POWER:
+      return setSubsecondResolution(1);
+    case BALANCED:
+      return setSubsecondResolution(1024);
+    case FINEST_RESOLUTION:
+    default:
+      return setSubsecondResolution(UINT32_MAX);
+  }
+}
+
+/**
+  * @brief  estimate the part of the RTC current depending on the prescalers
+  * @retval SubSecond counter clock relative to the lowest power prescalers,
+  *         in percent (100 for the lowest power)
+  */
+uint32_t STM32RTC::getRelativeCurrent(void)
+{
+#if defined(STM32F1xx)
+  return 100;
+#else
+  return RTC_GetRelativeCurrent();
+#endif /* STM32F1xx */
+}
+
+/**
+  * @brief  enable the LSI frequency measurement when the RTC is initialized,
+  *         the prescalers are computed from the measured frequency instead
+  *         of LSI_VALUE.
+  * @note   This method must be called before begin(). Only used with the
+  *         LSI clock and prescalers not set by the user.
+  * @param  enable: true to measure the LSI frequency
+  * @retval None
+  */
+void STM32RTC::setLsiTrim(bool enable)
+{
+#if defined(RTC_LSI_TRIM_SUPPORT)
+  RTC_SetLsiTrim(enable);
+#else
+  UNUSED(enable);
+#endif /* RTC_LSI_TRIM_SUPPORT */
+}
+
+/**
+  * @brief  start the LSE without waiting for it in begin(): the RTC runs from
+  *         the LSI until pollLse() hands it over to the LSE.
+  * @note   This method must be called before begin(). Only used with the
+  *         LSE clock. Only the LSE start is asynchronous: the handover resets
+  *         the backup domain and blocks until the LSE restarts (see pollLse()).
+  *         The backup registers are saved and restored by the handover.
+  * @param  enable: true to start the LSE asynchronously
+  * @retval None
+  */
+void STM32RTC::setLseAsync(bool enable)
+{
+#if defined(RTC_LSE_ASYNC_SUPPORT)
+  RTC_SetLseAsync(enable);
+#else
+  UNUSED(enable);
+#endif /* RTC_LSE_ASYNC_SUPPORT */
+}
+
+/**
+  * @brief  check if the RTC runs from the LSI waiting for the LSE
+  * @retval true if the handover to the LSE is pending
+  */
+bool STM32RTC::isLsePending(void)
+{
+#if defined(RTC_LSE_ASYNC_SUPPORT)
+  return RTC_IsLsePending();
+#else
+  return false;
+#endif /* RTC_LSE_ASYNC_SUPPORT */
+}
+
+/**
+  * @brief  hand the RTC over to the LSE once it is ready, after an
+  *         asynchronous start (see setLseAsync()). To be called periodically
+  *         from the loop, not from an interrupt handler.
+  * @note   Blocking up to 2 seconds when switching: the backup domain reset
+  *         stops the LSE, which has to restart. The RTC is stopped meanwhile.
+  * @note   The calendar time and its subsecond phase are kept, including the
+  *         time the LSE takes to restart, except in MODE_BIN where the
+  *         SubSecond counter restarts. The callback of an alarm due during
+  *         the switch is then called from this call (not in MODE_BIN).
+  * @retval true if the RTC has been switched to the LSE during this call
+  */
+bool STM32RTC::pollLse(void)
+{
+#if defined(RTC_LSE_ASYNC_SUPPORT)
+  uint32_t subSeconds = 0;
+  time_t epoch = 0;
+
+  if (!RTC_IsLsePending() || !RTC_IsLseReady()) {
+    return false;
+  }
+  if (_mode != MODE_BIN) {
+    epoch = getEpoch(&subSeconds);
+  }
+  uint32_t start = millis();
+  if (!RTC_HandoverLse()) {
+    return false;
+  }
+  if (_mode != MODE_BIN) {
+    subSeconds += millis() - start;
+    writeEpoch(epoch + subSeconds / 1000, subSeconds % 1000);
+    RTC_CatchUpAlarms((uint32_t)(epoch - EPOCH_TIME_OFF), (uint32_t)(epoch + subSeconds / 1000 - EPOCH_TIME_OFF));
+  } else {
+    calendarChanged();
+  }
+  if (_clockSourceCallback != nullptr) {
+    _clockSourceCallback(_clockSourceCallbackData);
+  }
+  return true;
+#else
+  return false;
+#endif /* RTC_LSE_ASYNC_SUPPORT */
+}
+
+/**
+  * @brief  attach a callback called by pollLse() once the RTC is handed
+  *         over to the LSE.
+  * @param  callback: pointer to the callback, nullptr to detach it
+  * @param  data: optional pointer passed to the callback
+  * @retval None
+  */
+void STM32RTC::attachClockSourceCallback(voidFuncPtrParam callback, void *data)
+{
+  _clockSourceCallback = callback;
+  _clockSourceCallbackData = data;
+}
+
+/**
+  * @brief  enable the LSE clock security system: on an LSE failure, the RTC
+  *         falls back to the LSI with computed prescalers, the calendar is
+  *         carried forward (MODE_BCD only) and the LSE failure callback is
+  *         called. getClockSource() still returns LSE_CLOCK. The callback
+  *         of an alarm due over the outage is called from the fallback.
+  * @note   The failure is polled, without interrupt: the fallback is done by
+  *         the next isClockDegraded() call. The RTC is stopped meanwhile, so
+  *         isClockDegraded() has to be called periodically from the loop.
+  * @param  enable: true to enable the LSE CSS
+  * @retval None
+  */
+void STM32RTC::setLseCss(bool enable)
+{
+#if defined(RTC_LSECSS_SUPPORT)
+  RTC_SetLseCss(enable);
+#else
+  UNUSED(enable);
+#endif /* RTC_LSECSS_SUPPORT */
+}
+
+/**
+  * @brief  check if the LSE has failed, and fall back to the LSI if not done
+  *         yet (see setLseCss()). While the LSE runs, a call reads the time
+  *         the calendar is carried forward from on a failure, once the
+  *         calendar has been set or RTC_LSE_REF_INTERVAL ms after the last read.
+  * @note   Blocking during the fallback, which resets the backup domain.
+  * @param  timeLost: optional pointer where to store whether the calendar
+  *         could not be carried forward over the outage (no reference read,
+  *         MODE_BIN or MODE_MIX): it then restarted from the failure time.
+  * @retval true if the time accuracy is degraded, until the next reset
+  */
+bool STM32RTC::isClockDegraded(bool *timeLost)
+{
+#if defined(RTC_LSECSS_SUPPORT)
+  bool degraded = RTC_CheckLseCss();
+
+  if (timeLost != nullptr) {
+    *timeLost = RTC_IsLseTimeLost();
+  }
+  return degraded;
+#else
+  if (timeLost != nullptr) {
+    *timeLost = false;
+  }
+  return false;
+#endif /* RTC_LSECSS_SUPPORT */
+}
+
+/**
+  * @brief  attach a callback called once the RTC runs from the LSI after an
+  *         LSE failure, from isClockDegraded().
+  * @param  callback: pointer to the callback, nullptr to detach it
+  * @param  data: optional pointer passed to the callback
+  * @retval None
+  */
+void STM32RTC::attachLseFailureCallback(voidFuncPtrParam callback, void *data)
+{
+  _lseFailureCallback = callback;
+  _lseFailureCallbackData = data;
+}
+
+#if defined(RTC_LSECSS_SUPPORT)
+/**
+  * @brief  called by the RTC driver once the RTC runs from the LSI after an
+  *         LSE failure: the calendar has been rewritten and the drift can no
+  *         more be measured from the last reference.
+  * @param  data: pointer to the STM32RTC instance
+  * @retval None
+  */
+void STM32RTC::lseFailureHandler(void *data)
+{
+  STM32RTC *rtc = static_cast<STM32RTC *>(data);
+
+  rtc->calendarChanged();
+  if (rtc->_lseFailureCallback != nullptr) {
+    rtc->_lseFailureCallback(rtc->_lseFailureCallbackData);
+  }
+}
+#endif /* RTC_LSECSS_SUPPORT */
+
+/**
+  * @brief  measure the LSI frequency and update the computed prescalers,
+  *         can be called periodically to follow the LSI drift.
+  * @note   Blocking during the measure (RTC_MEASURE_TICKS SubSecond ticks,
+  *         250ms by default).
+  * @retval measured frequency in Hz, 0 if not done
+  */
+uint32_t STM32RTC::trimLsi(void)
+{
+#if defined(RTC_LSI_TRIM_SUPPORT)
+  uint32_t freq = RTC_TrimLsi();
+  if (freq != 0) {
+    calendarChanged();
+  }
+  return freq;
+#else
+  return 0;
+#endif /* RTC_LSI_TRIM_SUPPORT */
+}
+
 /**
   * @brief enable the RTC alarm.
   * @param match: Alarm_Match configuration
@@ -224,6 +512,7 @@ void STM32RTC::setPrediv(uint32_t predivA, uint32_t predivS)
   */
 void STM32RTC::enableAlarm(Alarm_Match match, Alarm name)
 {
+  loadAlarm(name);
 #ifdef RTC_ALARM_B
   if (name == ALARM_B) {
     _alarmBMatch = match;
@@ -246,38 +535,13 @@ void STM32RTC::enableAlarm(Alarm_Match match, Alarm name)
       }
       break;
     case MATCH_SUBSEC:
-      /* force _alarmday to 0 to go to the right alarm config in MIX mode */
-#ifdef RTC_ALARM_B
-      if (name == ALARM_B) {
-        RTC_StartAlarm(::ALARM_B, 0, 0, 0, 0,
-                       _alarmBSubSeconds, (_alarmBPeriod == AM) ? HOUR_AM : HOUR_PM,
-                       static_cast<uint8_t>(31UL));
-      } else
-#endif
-      {
-        RTC_StartAlarm(::ALARM_A, 0, 0, 0, 0,
-                       _alarmSubSeconds, (_alarmPeriod == AM) ? HOUR_AM : HOUR_PM,
-                       static_cast<uint8_t>(31UL));
-      }
-      break;
     case MATCH_YYMMDDHHMMSS://kept for compatibility
     case MATCH_MMDDHHMMSS:  //kept for compatibility
     case MATCH_DHHMMSS:
     case MATCH_HHMMSS:
     case MATCH_MMSS:
     case MATCH_SS:
-#ifdef RTC_ALARM_B
-      if (name == ALARM_B) {
-        RTC_StartAlarm(::ALARM_B, _alarmBDay, _alarmBHours, _alarmBMinutes, _alarmBSeconds,
-                       _alarmBSubSeconds, (_alarmBPeriod == AM) ? HOUR_AM : HOUR_PM,
-                       static_cast<uint8_t>(_alarmBMatch));
-      } else
-#endif
-      {
-        RTC_StartAlarm(::ALARM_A, _alarmDay, _alarmHours, _alarmMinutes, _alarmSeconds,
-                       _alarmSubSeconds, (_alarmPeriod == AM) ? HOUR_AM : HOUR_PM,
-                       static_cast<uint8_t>(_alarmMatch));
-      }
+      startAlarm(match, name);
       break;
     default:
       break;
@@ -352,6 +616,41 @@ void STM32RTC::detachSecondsInterrupt(void)
   detachSecondsIrqCallback();
 }
 
+/**
+  * @brief  keep the epoch time in RAM, updated by the RTC Seconds interrupt.
+  *         getEpoch() then reads the RAM counter and the SubSeconds register
+  *         only, without any calendar access.
+  * @note   Must be called after begin(). The Seconds interrupt callback
+  *         is still called if attached.
+  * @note   Disabled by default: the Seconds interrupt keeps running, so the
+  *         MCU is woken up from low power modes each second, which increases
+  *         the average current of low power applications.
+  * @retval None
+  */
+void STM32RTC::enableRamClock(void)
+{
+  RTC_StartSecondsCount();
+  seedRamClock();
+}
+
+/**
+  * @brief  stop keeping the epoch time in RAM.
+  * @retval None
+  */
+void STM32RTC::disableRamClock(void)
+{
+  RTC_StopSecondsCount();
+}
+
+/**
+  * @brief  check if the epoch time is kept in RAM.
+  * @retval True if enabled else false
+  */
+bool STM32RTC::isRamClockEnabled(void)
+{
+  return RTC_IsSecondsCountEnabled();
+}
+
 #endif /* ONESECOND_IRQn */
 
 #ifdef STM32WLxx
@@ -528,6 +827,47 @@ void STM32RTC::getDate(uint8_t *weekDay, uint8_t *day, uint8_t *month, uint8_t *
   }
 }
 
+/**
+  * @brief  get RTC date and time read at once from the RTC.
+  * @param  dateTime: reference to the DateTime structure to fill
+  * @retval none
+  */
+void STM32RTC::getDateTime(DateTime &dateTime)
+{
+  syncDateTime();
+  dateTime.year = _year;
+  dateTime.month = _month;
+  dateTime.day = _day;
+  dateTime.weekDay = _wday;
+  dateTime.hours = _hours;
+  dateTime.minutes = _minutes;
+  dateTime.seconds = _seconds;
+  dateTime.period = _hoursPeriod;
+  dateTime.subSeconds = _subSeconds;
+  dateTime.subSecondTicks = _subSecondTicks;
+}
+
+/**
+  * @brief  get a snapshot of the RTC date and time, read at once from the RTC.
+  * @retval Snapshot to be queried without any other RTC access
+  */
+STM32RTC::Snapshot STM32RTC::getSnapshot(void)
+{
+  DateTime dateTime;
+  getDateTime(dateTime);
+  return Snapshot(dateTime);
+}
+
+/**
+  * @brief  get the epoch time of the snapshot
+  * @retval epoch time in seconds
+  */
+time_t STM32RTC::Snapshot::getEpoch(void) const
+{
+  return epochFromCivil(_dateTime.year, _dateTime.month, _dateTime.day,
+                        _dateTime.hours, _dateTime.minutes, _dateTime.seconds);
+}
+
 /**
   * @brief  get RTC alarm subsecond.
   * @param  name: optional (default: ALARM_A)
@@ -537,7 +877,7 @@ void STM32RTC::getDate(uint8_t *weekDay, uint8_t *day, uint8_t *month, uint8_t *
 uint32_t STM32RTC::getAlarmSubSeconds(Alarm name)
 {
   uint32_t alarmSubSeconds = 0;
-  syncAlarmTime(name);
+  loadAlarm(name);
 #ifdef RTC_ALARM_B
   if (name == ALARM_B) {
     alarmSubSeconds =  _alarmBSubSeconds;
@@ -558,7 +898,7 @@ uint32_t STM32RTC::getAlarmSubSeconds(Alarm name)
 uint8_t STM32RTC::getAlarmSeconds(Alarm name)
 {
   uint8_t alarmSeconds = 0;
-  syncAlarmTime(name);
+  loadAlarm(name);
 #ifdef RTC_ALARM_B
   if (name == ALARM_B) {
     alarmSeconds =  _alarmBSeconds;
@@ -579,7 +919,7 @@ uint8_t STM32RTC::getAlarmSeconds(Alarm name)
 uint8_t STM32RTC::getAlarmMinutes(Alarm name)
 {
   uint8_t alarmMinutes = 0;
-  syncAlarmTime(name);
+  loadAlarm(name);
 #ifdef RTC_ALARM_B
   if (name == ALARM_B) {
     alarmMinutes =  _alarmBMinutes;
@@ -613,7 +953,7 @@ uint8_t STM32RTC::getAlarmHours(Alarm name)
 uint8_t STM32RTC::getAlarmHours(AM_PM *period, Alarm name)
 {
   uint8_t alarmHours = 0;
-  syncAlarmTime(name);
+  loadAlarm(name);
 #ifdef RTC_ALARM_B
   if (name == ALARM_B) {
     if (period != nullptr) {
@@ -640,7 +980,7 @@ uint8_t STM32RTC::getAlarmHours(AM_PM *period, Alarm name)
 uint8_t STM32RTC::getAlarmDay(Alarm name)
 {
   uint8_t alarmDay = 0;
-  syncAlarmTime(name);
+  loadAlarm(name);
 #ifdef RTC_ALARM_B
   if (name == ALARM_B) {
     alarmDay =  _alarmBDay;
@@ -685,12 +1025,22 @@ uint8_t STM32RTC::getAlarmYear(void)
   */
 void STM32RTC::setSubSeconds(uint32_t subSeconds)
 {
+#if defined(RTC_SHIFTR_SUBFS)
+  /* Shift the running calendar, the time is not written */
+  if ((subSeconds < 1000) && RTC_SetSubSeconds(subSeconds)) {
+    _subSeconds = subSeconds;
+    calendarChanged();
+    _timeSet = true;
+    return;
+  }
+#endif /* RTC_SHIFTR_SUBFS */
   syncTime();
   if (subSeconds < 1000) {
     _subSeconds = subSeconds;
   }
-  RTC_SetTime(_hours, _minutes, _seconds, _subSeconds, (_hoursPeriod == AM) ? HOUR_AM : HOUR_PM);
-  _timeSet = true;
+  if (RTC_SetTime(_hours, _minutes, _seconds, _subSeconds, (_hoursPeriod == AM) ? HOUR_AM : HOUR_PM)) {
+    _timeSet = true;
+  }
 }
 
 /**
@@ -700,12 +1050,7 @@ void STM32RTC::setSubSeconds(uint32_t subSeconds)
   */
 void STM32RTC::setSeconds(uint8_t seconds)
 {
-  syncTime();
-  if (seconds < 60) {
-    _seconds = seconds;
-  }
-  RTC_SetTime(_hours, _minutes, _seconds, _subSeconds, (_hoursPeriod == AM) ? HOUR_AM : HOUR_PM);
-  _timeSet = true;
+  edit().seconds(seconds).commit();
 }
 
 /**
@@ -715,12 +1060,7 @@ void STM32RTC::setSeconds(uint8_t seconds)
   */
 void STM32RTC::setMinutes(uint8_t minutes)
 {
-  syncTime();
-  if (minutes < 60) {
-    _minutes = minutes;
-  }
-  RTC_SetTime(_hours, _minutes, _seconds, _subSeconds, (_hoursPeriod == AM) ? HOUR_AM : HOUR_PM);
-  _timeSet = true;
+  edit().minutes(minutes).commit();
 }
 
 /**
@@ -731,15 +1071,7 @@ void STM32RTC::setMinutes(uint8_t minutes)
   */
 void STM32RTC::setHours(uint8_t hours, AM_PM period)
 {
-  syncTime();
-  if (hours < 24) {
-    _hours = hours;
-  }
-  if (_format == HOUR_12) {
-    _hoursPeriod = period;
-  }
-  RTC_SetTime(_hours, _minutes, _seconds, _subSeconds, (_hoursPeriod == AM) ? HOUR_AM : HOUR_PM);
-  _timeSet = true;
+  edit().hours(hours, period).commit();
 }
 
 /**
@@ -747,30 +1079,14 @@ void STM32RTC::setHours(uint8_t hours, AM_PM period)
   * @param  hours: 0-23
   * @param  minutes: 0-59
   * @param  seconds: 0-59
-  * @param  subSeconds: 0-999 (optional)
+  * @param  subSeconds: 0-999 (optional), if not given the second starts
+  *         when the time is set, as the subsecond phase restarts
   * @param  period: hour format AM or PM (optional)
   * @retval none
   */
 void STM32RTC::setTime(uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSeconds, AM_PM period)
 {
-  syncTime();
-  if (subSeconds < 1000) {
-    _subSeconds = subSeconds;
-  }
-  if (seconds < 60) {
-    _seconds = seconds;
-  }
-  if (minutes < 60) {
-    _minutes = minutes;
-  }
-  if (hours < 24) {
-    _hours = hours;
-  }
-  if (_format == HOUR_12) {
-    _hoursPeriod = period;
-  }
-  RTC_SetTime(_hours, _minutes, _seconds, _subSeconds, (_hoursPeriod == AM) ? HOUR_AM : HOUR_PM);
-  _timeSet = true;
+  edit().hours(hours, period).minutes(minutes).seconds(seconds).subSeconds(subSeconds).commit();
 }
 
 /**
@@ -780,12 +1096,7 @@ void STM32RTC::setTime(uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t
   */
 void STM32RTC::setWeekDay(uint8_t weekDay)
 {
-  syncDate();
-  if ((weekDay >= 1) && (weekDay <= 7)) {
-    _wday = weekDay;
-  }
-  RTC_SetDate(_year, _month, _day, _wday);
-  _timeSet = true;
+  edit().weekDay(weekDay).commit();
 }
 
 /**
@@ -795,12 +1106,7 @@ void STM32RTC::setWeekDay(uint8_t weekDay)
   */
 void STM32RTC::setDay(uint8_t day)
 {
-  syncDate();
-  if ((day >= 1) && (day <= 31)) {
-    _day = day;
-  }
-  RTC_SetDate(_year, _month, _day, _wday);
-  _timeSet = true;
+  edit().day(day).commit();
 }
 
 /**
@@ -810,12 +1116,7 @@ void STM32RTC::setDay(uint8_t day)
   */
 void STM32RTC::setMonth(uint8_t month)
 {
-  syncDate();
-  if ((month >= 1) && (month <= 12)) {
-    _month = month;
-  }
-  RTC_SetDate(_year, _month, _day, _wday);
-  _timeSet = true;
+  edit().month(month).commit();
 }
 
 /**
@@ -825,12 +1126,7 @@ void STM32RTC::setMonth(uint8_t month)
   */
 void STM32RTC::setYear(uint8_t year)
 {
-  syncDate();
-  if (year < 100) {
-    _year = year;
-  }
-  RTC_SetDate(_year, _month, _day, _wday);
-  _timeSet = true;
+  edit().year(year).commit();
 }
 
 /**
@@ -842,18 +1138,7 @@ void STM32RTC::setYear(uint8_t year)
   */
 void STM32RTC::setDate(uint8_t day, uint8_t month, uint8_t year)
 {
-  syncDate();
-  if ((day >= 1) && (day <= 31)) {
-    _day = day;
-  }
-  if ((month >= 1) && (month <= 12)) {
-    _month = month;
-  }
-  if (year < 100) {
-    _year = year;
-  }
-  RTC_SetDate(_year, _month, _day, _wday);
-  _timeSet = true;
+  edit().day(day).month(month).year(year).commit();
 }
 
 /**
@@ -866,21 +1151,128 @@ void STM32RTC::setDate(uint8_t day, uint8_t month, uint8_t year)
   */
 void STM32RTC::setDate(uint8_t weekDay, uint8_t day, uint8_t month, uint8_t year)
 {
-  syncDate();
-  if ((weekDay >= 1) && (weekDay <= 7)) {
-    _wday = weekDay;
+  edit().weekDay(weekDay).day(day).month(month).year(year).commit();
+}
+
+/**
+  * @brief  write the collected date and time changes to the RTC.
+  *         The calendar is read only if some fields of the updated
+  *         registers are not set, then written in a single update.
+  * @note   If the time is changed without subseconds, the subsecond phase
+  *         restarts: the new second starts when the time is set.
+  * @retval none
+  */
+void STM32RTC::Editor::commit(void)
+{
+  uint8_t timeDirty = _dirty & TIME_FIELDS;
+  uint8_t dateDirty = _dirty & DATE_FIELDS;
+  /* Subseconds are not read back: without them, the second restarts */
+  bool readTime = (timeDirty != 0) && ((timeDirty | SUBSECONDS_FIELD) != TIME_FIELDS);
+  bool readDate = (dateDirty != 0) && (dateDirty != DATE_FIELDS);
+  bool status = true;
+
+  if (_dirty == 0) {
+    return;
   }
-  if ((day >= 1) && (day <= 31)) {
-    _day = day;
+  if (readTime && readDate) {
+    _rtc.syncDateTime();
+  } else if (readTime) {
+    _rtc.syncTime();
+  } else if (readDate) {
+    _rtc.syncDate();
   }
-  if ((month >= 1) && (month <= 12)) {
-    _month = month;
+
+  if (timeDirty != 0) {
+    _rtc._subSeconds = (_dirty & SUBSECONDS_FIELD) ? _dateTime.subSeconds : 0;
   }
-  if (year < 100) {
-    _year = year;
+  if (_dirty & SECONDS_FIELD) {
+    _rtc._seconds = _dateTime.seconds;
+  }
+  if (_dirty & MINUTES_FIELD) {
+    _rtc._minutes = _dateTime.minutes;
+  }
+  if (_dirty & HOURS_FIELD) {
+    _rtc._hours = _dateTime.hours;
+    if (_rtc._format == HOUR_12) {
+      _rtc._hoursPeriod = _dateTime.period;
+    }
+  }
+  if (_dirty & WEEKDAY_FIELD) {
+    _rtc._wday = _dateTime.weekDay;
+  }
+  if (_dirty & DAY_FIELD) {
+    _rtc._day = _dateTime.day;
+  }
+  if (_dirty & MONTH_FIELD) {
+    _rtc._month = _dateTime.month;
+  }
+  if (_dirty & YEAR_FIELD) {
+    _rtc._year = _dateTime.year;
+  }
+
+  hourAM_PM_t period = (_rtc._hoursPeriod == AM) ? HOUR_AM : HOUR_PM;
+  if ((timeDirty != 0) && (dateDirty != 0)) {
+    dateTime_t rtcDateTime;
+    rtcDateTime.year = _rtc._year;
+    rtcDateTime.month = _rtc._month;
+    rtcDateTime.day = _rtc._day;
+    rtcDateTime.wday = _rtc._wday;
+    rtcDateTime.hours = _rtc._hours;
+    rtcDateTime.minutes = _rtc._minutes;
+    rtcDateTime.seconds = _rtc._seconds;
+    rtcDateTime.period = period;
+    rtcDateTime.subSeconds = _rtc._subSeconds;
+    rtcDateTime.subSecondTicks = 0;
+    status = RTC_SetDateTime(&rtcDateTime);
+  } else if (timeDirty != 0) {
+    status = RTC_SetTime(_rtc._hours, _rtc._minutes, _rtc._seconds, _rtc._subSeconds, period);
+  } else {
+    status = RTC_SetDate(_rtc._year, _rtc._month, _rtc._day, _rtc._wday);
+  }
+  _rtc.calendarChanged();
+  if (status) {
+    _rtc._timeSet = true;
+  }
+  _dirty = 0;
+}
+
+/**
+  * @brief  set RTC date and time at once (single RTC calendar update).
+  * @param  dateTime: reference to the date and time to set (subseconds: 0-999 ms)
+  * @retval none
+  */
+void STM32RTC::setDateTime(const DateTime &dateTime)
+{
+  dateTime_t rtcDateTime;
+
+  if ((dateTime.weekDay >= 1) && (dateTime.weekDay <= 7) &&
+      (dateTime.day >= 1) && (dateTime.day <= 31) &&
+      (dateTime.month >= 1) && (dateTime.month <= 12) && (dateTime.year < 100) &&
+      (dateTime.hours < 24) && (dateTime.minutes < 60) && (dateTime.seconds < 60)) {
+    _year = dateTime.year;
+    _month = dateTime.month;
+    _day = dateTime.day;
+    _wday = dateTime.weekDay;
+    _hours = dateTime.hours;
+    _minutes = dateTime.minutes;
+    _seconds = dateTime.seconds;
+    _hoursPeriod = dateTime.period;
+
+    rtcDateTime.year = _year;
+    rtcDateTime.month = _month;
+    rtcDateTime.day = _day;
+    rtcDateTime.wday = _wday;
+    rtcDateTime.hours = _hours;
+    rtcDateTime.minutes = _minutes;
+    rtcDateTime.seconds = _seconds;
+    rtcDateTime.period = (_hoursPeriod == AM) ? HOUR_AM : HOUR_PM;
+    rtcDateTime.subSeconds = (dateTime.subSeconds < 1000) ? dateTime.subSeconds : 0;
+    rtcDateTime.subSecondTicks = 0;
+    if (RTC_SetDateTime(&rtcDateTime)) {
+      _timeSet = true;
+    }
+    calendarChanged();
   }
-  RTC_SetDate(_year, _month, _day, _wday);
-  _timeSet = true;
 }
 
 /**
@@ -896,13 +1288,16 @@ void STM32RTC::setAlarmSubSeconds(uint32_t subSeconds, Alarm name)
   UNUSED(name);
 #endif
   if ((_mode == MODE_BIN) || (subSeconds < 1000)) {
+    editAlarm(name);
 #ifdef RTC_ALARM_B
     if (name == ALARM_B) {
       _alarmBSubSeconds = subSeconds;
+      _alarmBSubSecondsInTicks = false;
     } else
 #endif
     {
       _alarmSubSeconds = subSeconds;
+      _alarmSubSecondsInTicks = false;
     }
   }
 }
@@ -917,6 +1312,7 @@ void STM32RTC::setAlarmSubSeconds(uint32_t subSeconds, Alarm name)
 void STM32RTC::setAlarmSeconds(uint8_t seconds, Alarm name)
 {
   if (seconds < 60) {
+    editAlarm(name);
 #ifdef RTC_ALARM_B
     if (name == ALARM_B) {
       _alarmBSeconds = seconds;
@@ -940,6 +1336,7 @@ void STM32RTC::setAlarmSeconds(uint8_t seconds, Alarm name)
 void STM32RTC::setAlarmMinutes(uint8_t minutes, Alarm name)
 {
   if (minutes < 60) {
+    editAlarm(name);
 #ifdef RTC_ALARM_B
     if (name == ALARM_B) {
       _alarmBMinutes = minutes;
@@ -976,6 +1373,7 @@ void STM32RTC::setAlarmHours(uint8_t hours, Alarm name)
 void STM32RTC::setAlarmHours(uint8_t hours, AM_PM period, Alarm name)
 {
   if (hours < 24) {
+    editAlarm(name);
 #ifdef RTC_ALARM_B
     if (name == ALARM_B) {
       _alarmBHours = hours;
@@ -1063,6 +1461,7 @@ void STM32RTC::setAlarmTime(uint8_t hours, uint8_t minutes, uint8_t seconds, uin
 void STM32RTC::setAlarmDay(uint8_t day, Alarm name)
 {
   if ((day >= 1) && (day <= 31)) {
+    editAlarm(name);
 #ifdef RTC_ALARM_B
     if (name == ALARM_B) {
       _alarmBDay = day;
@@ -1123,34 +1522,21 @@ void STM32RTC::setAlarmDate(uint8_t day, uint8_t month, uint8_t year, Alarm name
   */
 time_t STM32RTC::getEpoch(uint32_t *subSeconds)
 {
-  struct tm tm;
-
-  syncDate();
-  syncTime();
+  time_t epoch;
+#ifdef ONESECOND_IRQn
+  if (RTC_IsSecondsCountEnabled()) {
+    epoch = (time_t)RTC_GetSecondsCount(&_subSeconds, &_subSecondTicks);
+  } else
+#endif /* ONESECOND_IRQn */
+  {
+    epoch = syncEpoch();
+  }
 
-  /* fix race condition where date may have changed between reading date and time */
-  if (_seconds == 0 && _minutes == 0 && _hours == 0) {
-    syncDate();
-  }
-
-  tm.tm_isdst = -1;
-  /*
-   * mktime ignores the values supplied by the caller in the
-   * tm_wday and tm_yday fields
-   */
-  tm.tm_yday = 0;
-  tm.tm_wday = 0;
-  tm.tm_year = _year + EPOCH_TIME_YEAR_OFF;
-  tm.tm_mon = _month - 1;
-  tm.tm_mday = _day;
-  tm.tm_hour = _hours;
-  tm.tm_min = _minutes;
-  tm.tm_sec = _seconds;
   if (subSeconds != nullptr) {
     *subSeconds = _subSeconds;
   }
 
-  return mktime(&tm);
+  return epoch;
 }
 
 /**
@@ -1181,39 +1567,24 @@ time_t STM32RTC::getAlarmEpoch(Alarm name)
   */
 time_t STM32RTC::getAlarmEpoch(uint32_t *subSeconds, Alarm name)
 {
-  struct tm tm;
-
-  tm.tm_isdst = -1;
-  /*
-   * mktime ignores the values supplied by the caller in the
-   * tm_wday and tm_yday fields
-   */
-  tm.tm_yday = 0;
-  tm.tm_wday = 0;
-  tm.tm_year = _year + EPOCH_TIME_YEAR_OFF;
-  tm.tm_mon = _month - 1;
-  syncAlarmTime(name);
+  time_t epoch;
+
+  loadAlarm(name);
 #ifdef RTC_ALARM_B
   if (name == ALARM_B) {
-    tm.tm_mday = _alarmBDay;
-    tm.tm_hour = _alarmBHours;
-    tm.tm_min = _alarmBMinutes;
-    tm.tm_sec = _alarmBSeconds;
+    epoch = epochFromCivil(_year, _month, _alarmBDay, _alarmBHours, _alarmBMinutes, _alarmBSeconds);
     if (subSeconds != nullptr) {
       *subSeconds = _alarmBSubSeconds;
     }
   } else
 #endif
   {
-    tm.tm_mday = _alarmDay;
-    tm.tm_hour = _alarmHours;
-    tm.tm_min = _alarmMinutes;
-    tm.tm_sec = _alarmSeconds;
+    epoch = epochFromCivil(_year, _month, _alarmDay, _alarmHours, _alarmMinutes, _alarmSeconds);
     if (subSeconds != nullptr) {
       *subSeconds = _alarmSubSeconds;
     }
   }
-  return mktime(&tm);
+  return epoch;
 }
 
 /**
@@ -1238,19 +1609,15 @@ void STM32RTC::setAlarmEpoch(time_t ts, Alarm_Match match, Alarm name)
   */
 void STM32RTC::setAlarmEpoch(time_t ts, Alarm_Match match, uint32_t subSeconds, Alarm name)
 {
-  if (ts < EPOCH_TIME_OFF) {
-    ts = EPOCH_TIME_OFF;
-  }
-
-  time_t t = ts;
-  struct tm *tmp = gmtime(&t);
+  dateTime_t dateTime;
 
   /* in BIN only mode, the time_t is not relevant, but only the subSeconds in ms */
   if (_mode != MODE_BIN) {
-    setAlarmDay(tmp->tm_mday, name);
-    setAlarmHours(tmp->tm_hour, name);
-    setAlarmMinutes(tmp->tm_min, name);
-    setAlarmSeconds(tmp->tm_sec, name);
+    civilFromEpoch(ts, &dateTime);
+    setAlarmDay(dateTime.day, name);
+    setAlarmHours(dateTime.hours, name);
+    setAlarmMinutes(dateTime.minutes, name);
+    setAlarmSeconds(dateTime.seconds, name);
   }
   setAlarmSubSeconds(subSeconds, name);
   enableAlarm(match, name);
@@ -1263,29 +1630,48 @@ void STM32RTC::setAlarmEpoch(time_t ts, Alarm_Match match, uint32_t subSeconds,
   */
 void STM32RTC::setEpoch(time_t ts, uint32_t subSeconds)
 {
-  if (ts < EPOCH_TIME_OFF) {
-    ts = EPOCH_TIME_OFF;
+  if (_driftLearning) {
+    learnDrift(ts, subSeconds);
   }
+  if (!writeEpoch(ts, subSeconds)) {
+    return;
+  }
+  _timeSet = true;
 
-  time_t t = ts;
-  struct tm *tmp = gmtime(&t);
-
-  _year = tmp->tm_year - EPOCH_TIME_YEAR_OFF;
-  _month = tmp->tm_mon + 1;
-  _day = tmp->tm_mday;
-  if (tmp->tm_wday == 0) {
-    _wday = RTC_WEEKDAY_SUNDAY;
-  } else {
-    _wday = tmp->tm_wday;
+  if (_driftLearning) {
+    /* This time is the reference of the next correction */
+    _driftReference = (uint32_t)ts;
+    saveDriftState();
   }
-  _hours = tmp->tm_hour;
-  _minutes = tmp->tm_min;
-  _seconds = tmp->tm_sec;
+}
+
+/**
+  * @brief  write the RTC calendar from an epoch time
+  * @param  ts: epoch time in seconds
+  * @param  subSeconds: subseconds in ms
+  * @retval true if written, false if the RTC could not be updated
+  */
+bool STM32RTC::writeEpoch(time_t ts, uint32_t subSeconds)
+{
+  dateTime_t dateTime;
+  bool status;
+
+  civilFromEpoch(ts, &dateTime);
+
+  _year = dateTime.year;
+  _month = dateTime.month;
+  _day = dateTime.day;
+  _wday = dateTime.wday;
+  _hours = dateTime.hours;
+  _minutes = dateTime.minutes;
+  _seconds = dateTime.seconds;
   _subSeconds = subSeconds;
 
-  RTC_SetDate(_year, _month, _day, _wday);
-  RTC_SetTime(_hours, _minutes, _seconds, _subSeconds, (_hoursPeriod == AM) ? HOUR_AM : HOUR_PM);
-  _timeSet = true;
+  dateTime.period = (_hoursPeriod == AM) ? HOUR_AM : HOUR_PM;
+  dateTime.subSeconds = subSeconds;
+  status = RTC_SetDateTime(&dateTime);
+  calendarChanged();
+  return status;
 }
 
 /**
@@ -1297,6 +1683,301 @@ void STM32RTC::setY2kEpoch(time_t ts)
   setEpoch(ts + EPOCH_TIME_OFF);
 }
 
+/**
+  * @brief  get the 64bit monotonic nb of RTC ticks
+  * @note   In BIN or MIX mode, this is the free-running SubSecond downcounter
+  *         extended to 64bit, else it is computed from the calendar.
+  *         In BIN or MIX mode, without the SubSeconds underflow interrupt,
+  *         it must be called at least once per downcounter period
+  *         (about 36 hours at 32768Hz).
+  * @retval nb of ticks at getTickFrequency() Hz
+  */
+uint64_t STM32RTC::getTicks(void)
+{
+  uint64_t ticks;
+#if defined(RTC_BINARY_NONE)
+  if (_mode != MODE_BCD) {
+    ticks = RTC_GetTicks();
+  } else
+#endif /* RTC_BINARY_NONE */
+  {
+    ticks = (uint64_t)(getEpoch() - EPOCH_TIME_OFF);
+#if defined(RTC_SSR_SS)
+    ticks = (ticks * RTC_GetTicksPerSecond()) + _subSecondTicks;
+#endif /* RTC_SSR_SS */
+  }
+  return ticks;
+}
+
+/**
+  * @brief  get the frequency of the RTC ticks
+  * @retval nb of ticks per second
+  */
+uint32_t STM32RTC::getTickFrequency(void)
+{
+  return RTC_GetTickFrequency();
+}
+
+/**
+  * @brief  get the current time of the std::chrono wall clock
+  * @retval time point since the epoch, in ms
+  */
+STM32RTC::clock::time_point STM32RTC::clock::now() noexcept
+{
+  uint32_t subSeconds;
+  time_t epoch = STM32RTC::getInstance().getEpoch(&subSeconds);
+  return time_point(duration(((rep)epoch * 1000) + subSeconds));
+}
+
+/**
+  * @brief  get the nb of SubSecond ticks in one calendar second
+  * @note   This is the resolution of the tick based functions.
+  * @retval nb of ticks per second (synchronous prescaler + 1)
+  */
+uint32_t STM32RTC::ticksPerSecond(void)
+{
+  return RTC_GetTicksPerSecond();
+}
+
+/**
+  * @brief  get RTC subseconds in nb of ticks
+  * @retval 0-(ticksPerSecond() - 1) or 32bit nb of ticks in BIN mode
+  */
+uint32_t STM32RTC::getSubSecondTicks(void)
+{
+  syncDateTime();
+  return _subSecondTicks;
+}
+
+/**
+  * @brief  get epoch time with the subseconds in nb of ticks
+  * @param  subSecondTicks: pointer to where to store subseconds of the epoch in ticks
+  * @retval epoch time in seconds
+  */
+time_t STM32RTC::getEpochTicks(uint32_t *subSecondTicks)
+{
+  time_t epoch = getEpoch();
+
+  if (subSecondTicks != nullptr) {
+    *subSecondTicks = _subSecondTicks;
+  }
+  return epoch;
+}
+
+/**
+  * @brief  adjust the running calendar without a time step.
+  *         An offset lower than one second is applied at once with a shift of
+  *         the subseconds, a larger one is slewed over the adjust window (see
+  *         setAdjustWindow()) by temporarily changing the calibration.
+  * @note   The slew rate is limited to about +/-488 ppm, the window is
+  *         extended if needed. A new call cancels the slew in progress.
+  * @param  offsetTicks: nb of SubSecond ticks to advance (> 0) or delay (< 0)
+  *         the calendar, see ticksPerSecond()
+  * @retval true if the adjustment is applied or started, false if not
+  *         supported by the RTC or if the calibration cannot slew more
+  *         in this direction (the time is not changed)
+  */
+bool STM32RTC::adjustTime(int32_t offsetTicks)
+{
+  if (offsetTicks == 0) {
+    return true;
+  }
+#if defined(RTC_SHIFTR_SUBFS)
+  uint32_t nbTicks = (offsetTicks < 0) ? (uint32_t)(-(int64_t)offsetTicks) : (uint32_t)offsetTicks;
+  if (nbTicks < ticksPerSecond()) {
+#if defined(RTC_SLEW_SUPPORT)
+    RTC_StopSlew();
+#endif /* RTC_SLEW_SUPPORT */
+    if (RTC_ShiftSubSeconds(offsetTicks)) {
+      calendarChanged();
+      return true;
+    }
+    return false;
+  }
+#endif /* RTC_SHIFTR_SUBFS */
+#if defined(RTC_SLEW_SUPPORT)
+  if (RTC_StartSlew(offsetTicks, _adjustWindow)) {
+    /* The remainder of the offset may have been shifted */
+    calendarChanged();
+    return true;
+  }
+#endif /* RTC_SLEW_SUPPORT */
+  return false;
+}
+
+/**
+  * @brief  set the RTC smooth calibration, saved in a backup register to be
+  *         restored after an RTC init if RTC_BKP_CALIB is defined.
+  *         The RTC clock is corrected by steps of 2^-20 (0.954 ppm), with the
+  *         shortest calibration cycle giving the nearest correction.
+  * @note   The range is -487 to +488 ppm; STM32F1xx can only slow down the
+  *         RTC, from -121 to 0 ppm.
+  * @param  ppb: correction in parts per billion, > 0 to speed up the RTC
+  * @retval true if set, false if out of range or not supported
+  */
+bool STM32RTC::setCalibrationPpb(int32_t ppb)
+{
+#if defined(RTC_CALIB_SUPPORT)
+  return RTC_SetCalibration((int32_t)RTC_PulsesFromPpb(ppb));
+#else
+  UNUSED(ppb);
+  return false;
+#endif /* RTC_CALIB_SUPPORT */
+}
+
+/**
+  * @brief  get the RTC smooth calibration
+  * @retval correction in parts per billion, > 0 if the RTC is sped up
+  */
+int32_t STM32RTC::getCalibrationPpb(void)
+{
+#if defined(RTC_CALIB_SUPPORT)
+  return RTC_PpbFromPulses(RTC_GetCalibration());
+#else
+  return 0;
+#endif /* RTC_CALIB_SUPPORT */
+}
+
+/**
+  * @brief  enable the drift learning: each setEpoch() with a trusted time
+  *         measures the RTC drift since the previous one, the estimate is
+  *         updated and programmed in the smooth calibration.
+  *         The learning state is restored from the backup registers if
+  *         RTC_BKP_DRIFT is defined.
+  * @note   Any other change of the calendar (setTime(), adjustTime(), ...)
+  *         restarts the measure from the next setEpoch().
+  */
+void STM32RTC::enableDriftLearning(void)
+{
+  if (_driftLearning) {
+    return;
+  }
+  _driftReference = 0;
+  _drift = DriftEstimate();
+#if defined(RTC_BKP_DRIFT)
+#if defined(STM32F1xx)
+  uint32_t reference = (getBackupRegister(RTC_BKP_DRIFT) << 16) | (getBackupRegister(RTC_BKP_DRIFT + 1) & 0xFFFF);
+  uint32_t ppb = (getBackupRegister(RTC_BKP_DRIFT + 2) << 16) | (getBackupRegister(RTC_BKP_DRIFT + 3) & 0xFFFF);
+  uint32_t state = (getBackupRegister(RTC_BKP_DRIFT + 4) << 16) | (getBackupRegister(RTC_BKP_DRIFT + 5) & 0xFFFF);
+#else
+  uint32_t reference = getBackupRegister(RTC_BKP_DRIFT);
+  uint32_t ppb = getBackupRegister(RTC_BKP_DRIFT + 1);
+  uint32_t state = getBackupRegister(RTC_BKP_DRIFT + 2);
+#endif /* STM32F1xx */
+  if ((state >> 24) == DRIFT_STATE_MARKER) {
+    _driftReference = reference;
+    _drift.ppb = (int32_t)ppb;
+    _drift.weight = (uint16_t)state;
+    _drift.outliers = (uint8_t)(state >> 16);
+  }
+#endif /* RTC_BKP_DRIFT */
+  _driftLearning = true;
+}
+
+/**
+  * @brief  restart the drift learning, the calibration is not changed
+  */
+void STM32RTC::resetDriftLearning(void)
+{
+  _driftReference = 0;
+  _drift = DriftEstimate();
+  if (_driftLearning) {
+    saveDriftState();
+  }
+}
+
+/**
+  * @brief  measure the drift since the last reference before setting the time
+  * @param  ts: trusted epoch time in seconds
+  * @param  subSeconds: subseconds of the trusted time in milliseconds
+  */
+void STM32RTC::learnDrift(time_t ts, uint32_t subSeconds)
+{
+  if ((_driftReference != 0) && ((uint32_t)ts > _driftReference)) {
+    uint32_t rtcSubSeconds;
+    time_t rtcEpoch = getEpoch(&rtcSubSeconds);
+    int64_t errorMs = ((int64_t)(rtcEpoch - ts) * 1000) + ((rtcSubSeconds < 1000) ? rtcSubSeconds : 0) -
+                      ((subSeconds < 1000) ? subSeconds : 0);
+
+    if (RTC_DriftUpdate(&_drift, errorMs, (uint32_t)ts - _driftReference, getCalibrationPpb(), driftLimits)) {
+      setCalibrationPpb(-_drift.ppb);
+    }
+  }
+}
+
+/**
+  * @brief  save the drift learning state in the backup registers
+  */
+void STM32RTC::saveDriftState(void)
+{
+#if defined(RTC_BKP_DRIFT)
+  uint32_t state = ((uint32_t)DRIFT_STATE_MARKER << 24) | ((uint32_t)_drift.outliers << 16) | _drift.weight;
+#if defined(STM32F1xx)
+  setBackupRegister(RTC_BKP_DRIFT, _driftReference >> 16);
+  setBackupRegister(RTC_BKP_DRIFT + 1, _driftReference & 0xFFFF);
+  setBackupRegister(RTC_BKP_DRIFT + 2, (uint32_t)_drift.ppb >> 16);
+  setBackupRegister(RTC_BKP_DRIFT + 3, (uint32_t)_drift.ppb & 0xFFFF);
+  setBackupRegister(RTC_BKP_DRIFT + 4, state >> 16);
+  setBackupRegister(RTC_BKP_DRIFT + 5, state & 0xFFFF);
+#else
+  setBackupRegister(RTC_BKP_DRIFT, _driftReference);
+  setBackupRegister(RTC_BKP_DRIFT + 1, (uint32_t)_drift.ppb);
+  setBackupRegister(RTC_BKP_DRIFT + 2, state);
+#endif /* STM32F1xx */
+#endif /* RTC_BKP_DRIFT */
+}
+
+/**
+  * @brief  check if a time slew started by adjustTime() is in progress
+  * @retval true if in progress else false
+  */
+bool STM32RTC::isAdjusting(void)
+{
+#if defined(RTC_SLEW_SUPPORT)
+  return RTC_IsSlewing();
+#else
+  return false;
+#endif /* RTC_SLEW_SUPPORT */
+}
+
+/**
+  * @brief  get RTC alarm subseconds in nb of ticks
+  * @param  name: optional (default: ALARM_A)
+  *         ALARM_A or ALARM_B if exists
+  * @retval 0-(ticksPerSecond() - 1) or 32bit nb of ticks in BIN mode
+  */
+uint32_t STM32RTC::getAlarmSubSecondTicks(Alarm name)
+{
+  return RTC_GetAlarmSubSecondTicks(static_cast<alarm_t>(name));
+}
+
+/**
+  * @brief  set RTC alarm subseconds in nb of ticks, without millisecond conversion
+  * @param  subSecondTicks: 0-(ticksPerSecond() - 1) or 32bit nb of ticks in BIN mode
+  * @param  name: optional (default: ALARM_A)
+  *         ALARM_A or ALARM_B if exists
+  * @retval none
+  */
+void STM32RTC::setAlarmSubSecondTicks(uint32_t subSecondTicks, Alarm name)
+{
+#ifndef RTC_ALARM_B
+  UNUSED(name);
+#endif
+  if ((_mode == MODE_BIN) || (subSecondTicks < ticksPerSecond())) {
+    editAlarm(name);
+#ifdef RTC_ALARM_B
+    if (name == ALARM_B) {
+      _alarmBSubSecondTicks = subSecondTicks;
+      _alarmBSubSecondsInTicks = true;
+    } else
+#endif
+    {
+      _alarmSubSecondTicks = subSecondTicks;
+      _alarmSubSecondsInTicks = true;
+    }
+  }
+}
+
 /**
   * @brief  configure RTC source clock for low power
   * @param  none
@@ -1324,7 +2005,13 @@ void STM32RTC::configForLowPower(Source_Clock source)
 
   if (!isTimeSet()) {
     // Set arbitrary time for Lowpower; if not already set
-    setTime(12, 0, 0, 0, AM);
+    DateTime dateTime;
+    getDateTime(dateTime);
+    dateTime.hours = 12;
+    dateTime.minutes = 0;
+    dateTime.seconds = 0;
+    dateTime.period = AM;
+    setDateTime(dateTime);
   }
 #endif
 }
@@ -1364,6 +2051,50 @@ void STM32RTC::syncDate(void)
 #endif /* STM32F1xx */
 }
 
+/**
+  * @brief  synchronise the date and time from the current RTC ones at once
+  * @param  none
+  */
+void STM32RTC::syncDateTime(void)
+{
+  dateTime_t dateTime;
+
+  RTC_GetDateTime(&dateTime);
+  _year = dateTime.year;
+  _month = dateTime.month;
+  _day = dateTime.day;
+  _wday = dateTime.wday;
+  _hours = dateTime.hours;
+  _minutes = dateTime.minutes;
+  _seconds = dateTime.seconds;
+  _subSeconds = dateTime.subSeconds;
+  _subSecondTicks = dateTime.subSecondTicks;
+  _hoursPeriod = (dateTime.period == HOUR_AM) ? AM : PM;
+#if defined(STM32F1xx)
+  RTC_StoreDate();
+#endif /* STM32F1xx */
+}
+
+/**
+  * @brief  get the epoch time of the 00:00:00 of the last date read.
+  *         The value is computed only when the date changed.
+  * @param  none
+  * @retval epoch time in seconds
+  */
+time_t STM32RTC::getMidnightEpoch(void)
+{
+  uint32_t date = ((uint32_t)_year << 16) | ((uint32_t)_month << 8) | _day;
+
+  if (date != _epochCacheDate) {
+    _epochCacheMidnight = epochFromCivil(_year, _month, _day, 0, 0, 0);
+    _epochCacheDate = date;
+    _epochCacheMisses++;
+  } else {
+    _epochCacheHits++;
+  }
+  return _epochCacheMidnight;
+}
+
 /**
   * @brief  synchronise the specified alarm time from the current RTC one
   * @param  name: optional (default: ALARM_A)
@@ -1416,3 +2147,154 @@ void STM32RTC::syncAlarmTime(Alarm name)
       break;
   }
 }
+
+/**
+  * @brief  load the specified alarm from the RTC on its first use,
+  *         then it is served from the members
+  * @param  name: ALARM_A or ALARM_B if exists
+  */
+void STM32RTC::loadAlarm(Alarm name)
+{
+  if ((_alarmValid & alarmBit(name)) != 0) {
+    return;
+  }
+  syncAlarmTime(name);
+#ifdef RTC_ALARM_B
+  if (name == ALARM_B) {
+    if (!IS_RTC_DATE(_alarmBDay)) {
+      // Use current time to init alarm members,
+      // specially in case _alarmDay is 0 (reset value) which is an invalid value
+      syncDateTime();
+      _alarmBDay  = _day;
+      _alarmBHours = _hours;
+      _alarmBMinutes = _minutes;
+      _alarmBSeconds = _seconds;
+      _alarmBSubSeconds = _subSeconds;
+      _alarmBPeriod = _hoursPeriod;
+    }
+  } else
+#endif
+  {
+    if (!IS_RTC_DATE(_alarmDay)) {
+      // Use current time to init alarm members,
+      // specially in case _alarmDay is 0 (reset value) which is an invalid value
+      syncDateTime();
+      _alarmDay  = _day;
+      _alarmHours = _hours;
+      _alarmMinutes = _minutes;
+      _alarmSeconds = _seconds;
+      _alarmSubSeconds = _subSeconds;
+      _alarmPeriod = _hoursPeriod;
+    }
+  }
+  _alarmValid |= alarmBit(name);
+}
+
+/**
+  * @brief  load the specified alarm before a partial update of its members,
+  *         which are then not written to the RTC until the alarm is enabled
+  * @param  name: ALARM_A or ALARM_B if exists
+  */
+void STM32RTC::editAlarm(Alarm name)
+{
+  loadAlarm(name);
+  _alarmDirty |= alarmBit(name);
+}
+
+/**
+  * @brief  start the specified alarm with its current configuration
+  * @param  match: Alarm_Match configuration, except MATCH_OFF
+  * @param  name: ALARM_A or ALARM_B if exists
+  */
+void STM32RTC::startAlarm(Alarm_Match match, Alarm name)
+{
+  uint8_t day, hours, minutes, seconds;
+  uint32_t subSeconds;
+  bool inTicks;
+  AM_PM period;
+#ifdef RTC_ALARM_B
+  if (name == ALARM_B) {
+    day = _alarmBDay;
+    hours = _alarmBHours;
+    minutes = _alarmBMinutes;
+    seconds = _alarmBSeconds;
+    inTicks = _alarmBSubSecondsInTicks;
+    subSeconds = (inTicks) ? _alarmBSubSecondTicks : _alarmBSubSeconds;
+    period = _alarmBPeriod;
+  } else
+#endif
+  {
+    day = _alarmDay;
+    hours = _alarmHours;
+    minutes = _alarmMinutes;
+    seconds = _alarmSeconds;
+    inTicks = _alarmSubSecondsInTicks;
+    subSeconds = (inTicks) ? _alarmSubSecondTicks : _alarmSubSeconds;
+    period = _alarmPeriod;
+  }
+  uint8_t mask = static_cast<uint8_t>(match);
+  if (match == MATCH_SUBSEC) {
+    /* force day and time to 0 to go to the right alarm config in MIX mode */
+    day = hours = minutes = seconds = 0;
+    mask = static_cast<uint8_t>(31UL);
+  }
+  if (inTicks) {
+    RTC_StartAlarmTicks(static_cast<alarm_t>(name), day, hours, minutes, seconds,
+                        subSeconds, (period == AM) ? HOUR_AM : HOUR_PM, mask);
+  } else {
+    RTC_StartAlarm(static_cast<alarm_t>(name), day, hours, minutes, seconds,
+                   subSeconds, (period == AM) ? HOUR_AM : HOUR_PM, mask);
+  }
+  _alarmDirty &= ~alarmBit(name);
+}
+
+/**
+  * @brief  synchronise date and time from the RTC calendar
+  * @retval epoch time in seconds
+  */
+time_t STM32RTC::syncEpoch(void)
+{
+  syncDateTime();
+  return getMidnightEpoch() + ((time_t)_hours * 3600) + ((time_t)_minutes * 60) + _seconds;
+}
+
+/**
+  * @brief  to be called when the RTC calendar has been set:
+  *         invalidate the cached midnight epoch and update the RAM epoch time
+  */
+void STM32RTC::calendarChanged(void)
+{
+  _epochCacheDate = 0;
+  if (_driftLearning && (_driftReference != 0)) {
+    /* The drift can no more be measured from the last reference */
+    _driftReference = 0;
+    saveDriftState();
+  }
+#ifdef ONESECOND_IRQn
+  if (RTC_IsSecondsCountEnabled()) {
+    seedRamClock();
+  }
+#endif /* ONESECOND_IRQn */
+}
+
+#ifdef ONESECOND_IRQn
+/**
+  * @brief  set the RAM epoch time from the RTC calendar
+  * @note   A Seconds event pending while reading the calendar is already part
+  *         of it, so it is removed from the value as the interrupt will add it.
+  */
+void STM32RTC::seedRamClock(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  bool pending;
+  time_t epoch;
+
+  __disable_irq();
+  do {
+    pending = RTC_IsSecondsIrqPending();
+    epoch = syncEpoch();
+  } while (pending != RTC_IsSecondsIrqPending());
+  RTC_SetSecondsCount((uint32_t)epoch - (pending ? 1 : 0));
+  __set_PRIMASK(primask);
+}
+#endif /* ONESECOND_IRQn */
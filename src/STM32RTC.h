@@ -42,11 +42,13 @@
   #error "This library is not compatible with core version used. Please update the core."
 #endif
 #include "rtc.h"
+#include "rtc_math.h"
 // Check if RTC HAL enable in variants/board_name/stm32yzxx_hal_conf.h
 #ifndef HAL_RTC_MODULE_ENABLED
   #error "RTC configuration is missing. Check flag HAL_RTC_MODULE_ENABLED in variants/board_name/stm32yzxx_hal_conf.h"
 #endif
 #include <time.h>
+#include <chrono>
 
 /**
  * @brief STM32 RTC library version number
@@ -76,6 +78,53 @@
 #endif /* RCC_RTC_WDG_BLEWKUP_CLKSOURCE_HSI64M_DIV2048 || RCC_RTC_WDG_SUBG_LPAWUR_LCD_LCSC_CLKSOURCE_DIV512 */
 #define IS_HOUR_FORMAT(FMT)  (((FMT) == STM32RTC::HOUR_12) || ((FMT) == STM32RTC::HOUR_24))
 
+/*
+ * Default tick frequency of STM32RTC::steady_clock: the one of the default
+ * clock source (LSI) with computed prescalers, see rtcComputePredivA()
+ */
+#ifndef STM32RTC_STEADY_CLOCK_HZ
+#define STM32RTC_STEADY_CLOCK_HZ (LSI_VALUE / (rtcComputePredivA(LSI_VALUE) + 1))
+#endif
+
+/* Default duration in seconds of the time slew done by STM32RTC::adjustTime() */
+#ifndef STM32RTC_ADJUST_WINDOW
+#define STM32RTC_ADJUST_WINDOW 3600
+#endif
+
+/* Drift learning from the setEpoch() corrections */
+/* Minimum duration in seconds between two corrections to measure the drift */
+#ifndef STM32RTC_DRIFT_MIN_INTERVAL
+#define STM32RTC_DRIFT_MIN_INTERVAL 3600
+#endif
+/* Maximum deviation in ppb of a measure from the estimate, else rejected */
+#ifndef STM32RTC_DRIFT_OUTLIER_PPB
+#define STM32RTC_DRIFT_OUTLIER_PPB 10000
+#endif
+/* Nb of consecutive rejected measures to restart the learning */
+#ifndef STM32RTC_DRIFT_MAX_OUTLIERS
+#define STM32RTC_DRIFT_MAX_OUTLIERS 3
+#endif
+/* Maximum weight of the estimate in minutes of measure (30 days) */
+#ifndef STM32RTC_DRIFT_WINDOW
+#define STM32RTC_DRIFT_WINDOW 43200
+#endif
+#if STM32RTC_DRIFT_WINDOW > 65535
+#error "STM32RTC_DRIFT_WINDOW must fit in 16 bits"
+#endif
+
+/*
+ * Asynchronous prescaler for STM32RTC::Config, same search as RTC_computePrediv():
+ * the highest one giving a 1Hz calendar clock, else PREDIVA_MAX.
+ */
+constexpr uint32_t rtcComputePredivA(uint32_t clock)
+{
+#if defined(STM32F1xx)
+  return clock - 1;
+#else
+  return RTC_ComputePredivA(clock, PREDIVA_MAX, PREDIVS_MAX);
+#endif /* STM32F1xx */
+}
+
 class STM32RTC {
   public:
 
@@ -118,6 +167,12 @@ class STM32RTC {
 #endif /* RCC_RTC_WDG_BLEWKUP_CLKSOURCE_HSI64M_DIV2048 || RCC_RTC_WDG_SUBG_LPAWUR_LCD_LCSC_CLKSOURCE_DIV512 */
     };
 
+    enum PowerProfile : uint8_t {
+      LOWEST_POWER,      // Highest asynchronous prescaler
+      BALANCED,          // About 1ms SubSecond resolution
+      FINEST_RESOLUTION  // Lowest asynchronous prescaler
+    };
+
     enum Alarm : uint32_t {
       ALARM_A = ::ALARM_A,
 #ifdef RTC_ALARM_B
@@ -125,6 +180,248 @@ class STM32RTC {
 #endif
     };
 
+    /*
+     * RTC clock configuration computed at compile time, impossible ones
+     * are rejected. Hz is the frequency of the clock source (HSE before
+     * its division). Applied with setClockConfig<Config<...>>().
+     */
+    template <Source_Clock Source, uint32_t Hz, Binary_Mode Mode = MODE_BCD>
+    struct Config {
+      static constexpr Source_Clock source = Source;
+      static constexpr Binary_Mode mode = Mode;
+      static constexpr uint32_t hseDiv = (static_cast<uint8_t>(Source) == ::HSE_CLOCK) ? RTC_HSE_DIV(Hz) : 1;
+      static constexpr uint32_t clock = Hz / hseDiv;
+      static constexpr uint32_t predivA = rtcComputePredivA(clock);
+#if defined(STM32F1xx)
+      static constexpr uint32_t predivS = 0;
+#else
+      static constexpr uint32_t predivS = (clock / (predivA + 1)) - 1;
+      static_assert(clock > predivA, "RTC clock too low for the prescalers");
+      static_assert(predivS <= PREDIVS_MAX, "RTC clock too high for the prescalers");
+      static_assert((Mode != MODE_MIX) || (RTC_BinMixBcdU(clock / (predivA + 1)) != 0xFF),
+                    "No BCD increment for this RTC clock in MIX mode");
+#endif /* STM32F1xx */
+      static_assert(Hz != 0, "RTC clock must not be null");
+      static_assert(predivA <= PREDIVA_MAX, "RTC clock too high for the prescalers");
+      static_assert((static_cast<uint8_t>(Source) != ::HSE_CLOCK) ||
+                    ((Hz == HSE_VALUE) && (hseDiv <= RTC_HSE_DIV_MAX) && (clock <= HSE_RTC_MAX)),
+                    "HSE frequency must be HSE_VALUE and divided to at most HSE_RTC_MAX");
+    };
+
+    struct DateTime {
+      uint8_t  year;       // 0-99
+      uint8_t  month;      // 1-12
+      uint8_t  day;        // 1-31
+      uint8_t  weekDay;    // 1-7 (Monday first)
+      uint8_t  hours;      // 0-12 or 0-23 depends on the hours mode
+      uint8_t  minutes;    // 0-59
+      uint8_t  seconds;    // 0-59
+      AM_PM    period;     // AM or PM
+      uint32_t subSeconds; // 0-999 ms or 32bit nb of milliseconds in BIN mode
+      uint32_t subSecondTicks; // 0-(ticksPerSecond() - 1) or 32bit nb of ticks in BIN mode
+    };
+
+    /* Date and time read once from the RTC, to be queried many times */
+    class Snapshot {
+      public:
+        constexpr Snapshot(void) : _dateTime() {}
+        constexpr explicit Snapshot(const DateTime &dateTime) : _dateTime(dateTime) {}
+
+        constexpr uint32_t getSubSeconds(void) const
+        {
+          return _dateTime.subSeconds;
+        }
+        constexpr uint32_t getSubSecondTicks(void) const
+        {
+          return _dateTime.subSecondTicks;
+        }
+        constexpr uint8_t getSeconds(void) const
+        {
+          return _dateTime.seconds;
+        }
+        constexpr uint8_t getMinutes(void) const
+        {
+          return _dateTime.minutes;
+        }
+        constexpr uint8_t getHours(AM_PM *period = nullptr) const
+        {
+          if (period != nullptr) {
+            *period = _dateTime.period;
+          }
+          return _dateTime.hours;
+        }
+        constexpr uint8_t getWeekDay(void) const
+        {
+          return _dateTime.weekDay;
+        }
+        constexpr uint8_t getDay(void) const
+        {
+          return _dateTime.day;
+        }
+        constexpr uint8_t getMonth(void) const
+        {
+          return _dateTime.month;
+        }
+        constexpr uint8_t getYear(void) const
+        {
+          return _dateTime.year;
+        }
+        constexpr const DateTime &getDateTime(void) const
+        {
+          return _dateTime;
+        }
+        time_t getEpoch(void) const;
+
+      private:
+        DateTime _dateTime;
+    };
+
+    /*
+     * Date and time changes collected in RAM and written to the RTC
+     * in a single calendar update by commit().
+     * Out of range values are ignored, fields not set keep their current value.
+     */
+    class Editor {
+      public:
+        explicit Editor(STM32RTC &rtc) : _rtc(rtc), _dateTime(), _dirty(0) {}
+
+        Editor &subSeconds(uint32_t subSeconds)
+        {
+          if (subSeconds < 1000) {
+            _dateTime.subSeconds = subSeconds;
+            _dirty |= SUBSECONDS_FIELD;
+          }
+          return *this;
+        }
+        Editor &seconds(uint8_t seconds)
+        {
+          if (seconds < 60) {
+            _dateTime.seconds = seconds;
+            _dirty |= SECONDS_FIELD;
+          }
+          return *this;
+        }
+        Editor &minutes(uint8_t minutes)
+        {
+          if (minutes < 60) {
+            _dateTime.minutes = minutes;
+            _dirty |= MINUTES_FIELD;
+          }
+          return *this;
+        }
+        Editor &hours(uint8_t hours, AM_PM period = AM)
+        {
+          if (hours < 24) {
+            _dateTime.hours = hours;
+            _dateTime.period = period;
+            _dirty |= HOURS_FIELD;
+          }
+          return *this;
+        }
+        Editor &weekDay(uint8_t weekDay)
+        {
+          if ((weekDay >= 1) && (weekDay <= 7)) {
+            _dateTime.weekDay = weekDay;
+            _dirty |= WEEKDAY_FIELD;
+          }
+          return *this;
+        }
+        Editor &day(uint8_t day)
+        {
+          if ((day >= 1) && (day <= 31)) {
+            _dateTime.day = day;
+            _dirty |= DAY_FIELD;
+          }
+          return *this;
+        }
+        Editor &month(uint8_t month)
+        {
+          if ((month >= 1) && (month <= 12)) {
+            _dateTime.month = month;
+            _dirty |= MONTH_FIELD;
+          }
+          return *this;
+        }
+        Editor &year(uint8_t year)
+        {
+          if (year < 100) {
+            _dateTime.year = year;
+            _dirty |= YEAR_FIELD;
+          }
+          return *this;
+        }
+        void commit(void);
+
+      private:
+        enum : uint8_t {
+          SUBSECONDS_FIELD = 0x01,
+          SECONDS_FIELD    = 0x02,
+          MINUTES_FIELD    = 0x04,
+          HOURS_FIELD      = 0x08,
+          WEEKDAY_FIELD    = 0x10,
+          DAY_FIELD        = 0x20,
+          MONTH_FIELD      = 0x40,
+          YEAR_FIELD       = 0x80,
+          TIME_FIELDS      = 0x0F,
+          DATE_FIELDS      = 0xF0
+        };
+
+        STM32RTC &_rtc;
+        DateTime _dateTime;
+        uint8_t  _dirty;
+    };
+
+    /* Crystal drift estimate of the drift learning, weighted by the measure duration */
+    typedef driftEstimate_t DriftEstimate;
+
+    /* std::chrono wall clock, based on the epoch time */
+    struct clock {
+      typedef int64_t rep;
+      typedef std::milli period;
+      typedef std::chrono::duration<rep, period> duration;
+      typedef std::chrono::time_point<clock> time_point;
+      static constexpr bool is_steady = false;
+
+      static time_point now() noexcept;
+
+      static time_t to_time_t(const time_point &t) noexcept
+      {
+        return static_cast<time_t>(std::chrono::duration_cast<std::chrono::seconds>(t.time_since_epoch()).count());
+      }
+      static time_point from_time_t(time_t t) noexcept
+      {
+        return time_point(std::chrono::duration_cast<duration>(std::chrono::seconds(t)));
+      }
+    };
+
+    /*
+     * std::chrono clock based on getTicks(), monotonic in MODE_BIN and MODE_MIX.
+     * Hz should match getTickFrequency() to avoid a runtime scaling.
+     * Mode is the binary mode used: in MODE_BCD, ticks are computed from the
+     * calendar, so the clock is not steady as setting the time changes it.
+     */
+    template <uint32_t Hz, Binary_Mode Mode = MODE_BCD>
+    struct basic_steady_clock {
+      static_assert(Hz != 0, "Tick frequency must not be null");
+      typedef int64_t rep;
+      typedef std::ratio<1, Hz> period;
+      typedef std::chrono::duration<rep, period> duration;
+      typedef std::chrono::time_point<basic_steady_clock> time_point;
+      static constexpr bool is_steady = (Mode != MODE_BCD);
+
+      static time_point now() noexcept
+      {
+        STM32RTC &rtc = STM32RTC::getInstance();
+        uint64_t ticks = RTC_ScaleTicks(rtc.getTicks(), rtc.getTickFrequency(), Hz);
+        return time_point(duration(static_cast<rep>(ticks)));
+      }
+    };
+    /*
+     * Default binary mode (MODE_BCD): not steady. With the RTC started in
+     * MODE_BIN or MODE_MIX, use basic_steady_clock<Hz, MODE_BIN> instead.
+     */
+    typedef basic_steady_clock<STM32RTC_STEADY_CLOCK_HZ> steady_clock;
+
     static STM32RTC &getInstance()
     {
       static STM32RTC instance; // Guaranteed to be destroyed.
@@ -150,6 +447,26 @@ class STM32RTC {
     void setClockSource(Source_Clock source, uint32_t predivA = (PREDIVA_MAX + 1), uint32_t predivS = (PREDIVS_MAX + 1));
     void getPrediv(uint32_t *predivA, uint32_t *predivS);
     void setPrediv(uint32_t predivA, uint32_t predivS);
+    template <class C>
+    void setClockConfig(void)
+    {
+      _clockSource = C::source;
+      setBinaryMode(C::mode);
+      RTC_SetClockConfig(static_cast<sourceClock_t>(C::source), C::clock, C::predivA, C::predivS);
+    }
+    uint32_t setSubsecondResolution(uint32_t ticksPerSecond);
+    uint32_t setPowerProfile(PowerProfile profile);
+    uint32_t getRelativeCurrent(void);
+    void setLsiTrim(bool enable);
+    uint32_t trimLsi(void);
+    void setLseAsync(bool enable);
+    bool isLsePending(void);
+    // Blocking up to 2 seconds when it switches the RTC to the LSE: from the loop only.
+    bool pollLse(void);
+    void attachClockSourceCallback(voidFuncPtrParam callback, void *data = nullptr);
+    void setLseCss(bool enable);
+    bool isClockDegraded(bool *timeLost = nullptr);
+    void attachLseFailureCallback(voidFuncPtrParam callback, void *data = nullptr);
 
     Binary_Mode getBinaryMode(void);
     void setBinaryMode(Binary_Mode mode);
@@ -165,6 +482,10 @@ class STM32RTC {
     // Other mcu than stm32F1 will use the WakeUp feature to interrupt each second.
     void attachSecondsInterrupt(voidFuncPtrParam callback);
     void detachSecondsInterrupt(void);
+    // Epoch time kept in RAM by the Seconds interrupt
+    void enableRamClock(void);
+    void disableRamClock(void);
+    bool isRamClockEnabled(void);
 
 #endif /* ONESECOND_IRQn */
 #ifdef STM32WLxx
@@ -189,6 +510,9 @@ class STM32RTC {
     uint8_t getYear(void);
     void getDate(uint8_t *weekDay, uint8_t *day, uint8_t *month, uint8_t *year);
 
+    void getDateTime(DateTime &dateTime);
+    Snapshot getSnapshot(void);
+
     uint32_t getAlarmSubSeconds(Alarm name = ALARM_A);
     uint8_t getAlarmSeconds(Alarm name = ALARM_A);
     uint8_t getAlarmMinutes(Alarm name = ALARM_A);
@@ -216,6 +540,12 @@ class STM32RTC {
     void setDate(uint8_t day, uint8_t month, uint8_t year);
     void setDate(uint8_t weekDay, uint8_t day, uint8_t month, uint8_t year);
 
+    void setDateTime(const DateTime &dateTime);
+    Editor edit(void)
+    {
+      return Editor(*this);
+    }
+
     void setAlarmSubSeconds(uint32_t subSeconds, Alarm name = ALARM_A);
     void setAlarmSeconds(uint8_t seconds, Alarm name = ALARM_A);
     void setAlarmMinutes(uint8_t minutes, Alarm name = ALARM_A);
@@ -244,6 +574,60 @@ class STM32RTC {
     void setAlarmEpoch(time_t ts, Alarm_Match match, Alarm name);
     void setAlarmEpoch(time_t ts, Alarm_Match match = MATCH_DHHMMSS, uint32_t subSeconds = 0, Alarm name = ALARM_A);
 
+    /* Ticks Functions */
+
+    uint64_t getTicks(void);
+    uint32_t getTickFrequency(void);
+
+    uint32_t ticksPerSecond(void);
+    uint32_t getSubSecondTicks(void);
+    time_t getEpochTicks(uint32_t *subSecondTicks);
+    uint32_t getAlarmSubSecondTicks(Alarm name = ALARM_A);
+    void setAlarmSubSecondTicks(uint32_t subSecondTicks, Alarm name = ALARM_A);
+
+    /* Time Adjustment Functions */
+
+    bool adjustTime(int32_t offsetTicks);
+    void setAdjustWindow(uint32_t seconds)
+    {
+      if (seconds != 0) {
+        _adjustWindow = seconds;
+      }
+    }
+    uint32_t getAdjustWindow(void)
+    {
+      return _adjustWindow;
+    }
+    bool isAdjusting(void);
+
+    /* Calibration Functions */
+
+    bool setCalibrationPpb(int32_t ppb);
+    int32_t getCalibrationPpb(void);
+    bool setCalibrationPpm(float ppm)
+    {
+      return setCalibrationPpb((int32_t)((ppm * 1000.0f) + ((ppm < 0.0f) ? -0.5f : 0.5f)));
+    }
+    float getCalibrationPpm(void)
+    {
+      return (float)getCalibrationPpb() / 1000.0f;
+    }
+
+    void enableDriftLearning(void);
+    void disableDriftLearning(void)
+    {
+      _driftLearning = false;
+    }
+    bool isDriftLearningEnabled(void)
+    {
+      return _driftLearning;
+    }
+    void resetDriftLearning(void);
+    int32_t getDriftPpb(void)
+    {
+      return _drift.ppb;
+    }
+
     bool isConfigured(void)
     {
       return RTC_IsConfigured();
@@ -257,13 +641,32 @@ class STM32RTC {
     {
       return _timeSet;
     }
+    uint32_t getEpochCacheHits(void)
+    {
+      return _epochCacheHits;
+    }
+    uint32_t getEpochCacheMisses(void)
+    {
+      return _epochCacheMisses;
+    }
+    uint32_t getReadCount(void)
+    {
+      return RTC_GetReadCount();
+    }
 
     friend class STM32LowPower;
 
   private:
-    STM32RTC(void): _mode(MODE_BCD), _clockSource(LSI_CLOCK)
+    STM32RTC(void): _mode(MODE_BCD), _alarmValid(0), _alarmDirty(0), _clockSource(LSI_CLOCK), _epochCacheDate(0),
+      _epochCacheHits(0), _epochCacheMisses(0), _adjustWindow(STM32RTC_ADJUST_WINDOW),
+      _driftLearning(false), _driftReference(0), _drift(),
+      _clockSourceCallback(nullptr), _clockSourceCallbackData(nullptr),
+      _lseFailureCallback(nullptr), _lseFailureCallbackData(nullptr)
     {
       setClockSource(_clockSource);
+#if defined(RTC_LSECSS_SUPPORT)
+      ::attachLseFailureCallback(lseFailureHandler, this);
+#endif /* RTC_LSECSS_SUPPORT */
     }
 
     static bool _timeSet;
@@ -275,6 +678,7 @@ class STM32RTC {
     uint8_t     _minutes;
     uint8_t     _seconds;
     uint32_t    _subSeconds;
+    uint32_t    _subSecondTicks;
     uint8_t     _year;
     uint8_t     _month;
     uint8_t     _day;
@@ -286,6 +690,8 @@ class STM32RTC {
     uint8_t     _alarmMinutes;
     uint8_t     _alarmSeconds;
     uint32_t    _alarmSubSeconds;
+    uint32_t    _alarmSubSecondTicks;
+    bool        _alarmSubSecondsInTicks;
     AM_PM       _alarmPeriod;
     Alarm_Match _alarmMatch;
 
@@ -296,17 +702,64 @@ class STM32RTC {
     uint8_t     _alarmBMinutes;
     uint8_t     _alarmBSeconds;
     uint32_t    _alarmBSubSeconds;
+    uint32_t    _alarmBSubSecondTicks;
+    bool        _alarmBSubSecondsInTicks;
     AM_PM       _alarmBPeriod;
     Alarm_Match _alarmBMatch;
 #endif
+    /* Alarms loaded from the RTC, alarms with values not yet written to it */
+    uint8_t     _alarmValid;
+    uint8_t     _alarmDirty;
 
     Source_Clock _clockSource;
 
+    /* Epoch of the 00:00:00 of the last date read */
+    uint32_t    _epochCacheDate;
+    time_t      _epochCacheMidnight;
+    uint32_t    _epochCacheHits;
+    uint32_t    _epochCacheMisses;
+
+    /* Duration in seconds of the time slew */
+    uint32_t    _adjustWindow;
+
+    bool          _driftLearning;
+    uint32_t      _driftReference; // epoch of the last setEpoch(), 0 if none
+    DriftEstimate _drift;
+
+    /* Called when the RTC is handed over to the LSE */
+    voidFuncPtrParam _clockSourceCallback;
+    void            *_clockSourceCallbackData;
+
+    /* Called once the RTC runs from the LSI after an LSE failure */
+    voidFuncPtrParam _lseFailureCallback;
+    void            *_lseFailureCallbackData;
+
     void configForLowPower(Source_Clock source);
+#if defined(RTC_LSECSS_SUPPORT)
+    static void lseFailureHandler(void *data);
+#endif /* RTC_LSECSS_SUPPORT */
 
     void syncTime(void);
     void syncDate(void);
+    void syncDateTime(void);
+
+    time_t getMidnightEpoch(void);
+    time_t syncEpoch(void);
+    bool writeEpoch(time_t ts, uint32_t subSeconds);
+    void calendarChanged(void);
+    void learnDrift(time_t ts, uint32_t subSeconds);
+    void saveDriftState(void);
+#ifdef ONESECOND_IRQn
+    void seedRamClock(void);
+#endif /* ONESECOND_IRQn */
     void syncAlarmTime(Alarm name = ALARM_A);
+    void loadAlarm(Alarm name);
+    void editAlarm(Alarm name);
+    static uint8_t alarmBit(Alarm name)
+    {
+      return (name == ALARM_A) ? 1U : 2U;
+    }
+    void startAlarm(Alarm_Match match, Alarm name);
 
 };
 
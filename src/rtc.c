@@ -35,6 +35,7 @@
   */
 
 #include "rtc.h"
+#include "rtc_math.h"
 #include "stm32yyxx_ll_rtc.h"
 #include <string.h>
 
@@ -54,6 +55,37 @@ extern "C" {
 #endif
 
 /* Private define ------------------------------------------------------------*/
+#if defined(RTC_CR_BYPSHAD) && defined(RTC_SSR_SS)
+/* Maximum number of calendar reads when a second rollover is detected */
+#ifndef RTC_DATETIME_READ_MAX
+#define RTC_DATETIME_READ_MAX 3
+#endif
+#endif /* RTC_CR_BYPSHAD && RTC_SSR_SS */
+#if defined(RTC_LSECSS_SUPPORT)
+/* Minimum time in ms between two reads of the LSE failure reference */
+#ifndef RTC_LSE_REF_INTERVAL
+#define RTC_LSE_REF_INTERVAL 1000
+#endif
+#endif /* RTC_LSECSS_SUPPORT */
+/*
+ * Define RTC_FAST_READ to read the calendar registers directly instead of
+ * using HAL_RTC_GetTime()/HAL_RTC_GetDate() (not available for STM32F1xx)
+ */
+#if defined(RTC_FAST_READ) && defined(STM32F1xx)
+#undef RTC_FAST_READ
+#endif
+/* Masks of the BCD fields of the time and date registers, one per byte */
+#define RTC_TR_BCD_MASK (RTC_TR_HT | RTC_TR_HU | RTC_TR_MNT | RTC_TR_MNU | RTC_TR_ST | RTC_TR_SU)
+#define RTC_DR_BCD_MASK (RTC_DR_YT | RTC_DR_YU | RTC_DR_MT | RTC_DR_MU | RTC_DR_DT | RTC_DR_DU)
+#if !defined(STM32F1xx)
+/* Register layout used by RTC_PackTime() and RTC_PackDate() */
+#if (RTC_TR_HU_Pos != 16U) || (RTC_TR_MNU_Pos != 8U) || (RTC_TR_SU_Pos != 0U) || (RTC_TR_PM_Pos != 22U)
+#error "RTC_TR layout does not match RTC_PackTime()"
+#endif
+#if (RTC_DR_YU_Pos != 16U) || (RTC_DR_WDU_Pos != 13U) || (RTC_DR_MU_Pos != 8U) || (RTC_DR_DU_Pos != 0U)
+#error "RTC_DR layout does not match RTC_PackDate()"
+#endif
+#endif /* !STM32F1xx */
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 static RTC_HandleTypeDef RtcHandle = {.Instance = RTC};
@@ -65,12 +97,33 @@ static void *callbackUserDataB = NULL;
 #endif
 #ifdef ONESECOND_IRQn
 static voidCallbackPtr RTCSecondsIrqCallback = NULL;
+/* RAM seconds counter updated by the One-Second interrupt */
+static volatile uint32_t secondsCount = 0;
+static bool isSecondsCountEnabled = false;
+/* One-Second interrupt running and its event already handled by the callback */
+static volatile bool secondsIrqActive = false;
+static volatile bool secondsIrqHandled = false;
 #endif
+#if defined(RTC_SLEW_SUPPORT)
+/* Remaining seconds of the time slew and calibration to restore at its end */
+static volatile uint32_t slewSeconds = 0;
+static uint32_t slewCalibBase = 0;
+/* One-Second interrupt enabled for the time slew only */
+static bool slewSecondsIrq = false;
+#endif /* RTC_SLEW_SUPPORT */
 #ifdef STM32WLxx
 static voidCallbackPtr RTCSubSecondsUnderflowIrqCallback = NULL;
+static bool isSubSecondsUnderflowIrqSet = false;
 #endif
+#if defined(RTC_BINARY_NONE)
+/* Extend the free-running SubSecond downcounter to 64 bits */
+static volatile uint32_t ticksWrapCount = 0;
+static uint32_t ticksLast = 0;
+#endif /* RTC_BINARY_NONE */
 static sourceClock_t clkSrc = LSI_CLOCK;
 static uint32_t clkVal = LSI_VALUE;
+/* Clock frequency given by RTC_SetClockConfig(), not the nominal one */
+static bool clkConfigured = false;
 #if !defined(LL_RCC_LSCO_CLKSOURCE_HSI64M_DIV2048)
 static uint8_t HSEDiv = 0;
 #endif
@@ -80,23 +133,158 @@ static uint8_t predivSync_bits = 0xFF;
 static uint32_t predivAsync = (PREDIVA_MAX + 1);
 static uint32_t predivSync = (PREDIVS_MAX + 1);
 static uint32_t fqce_apre;
+/* Q32 reciprocals of fqce_apre and (predivSync + 1) to avoid divisions */
+static uint32_t fqce_apre_recip;
+static uint32_t predivSync_recip;
+/* Prescalers computed from the clock frequency, not set by the user */
+static bool predivComputed = true;
+/* RTC configured by RTC_init(), prescalers set before are written by it */
+static bool rtcInitialized = false;
+static bool predivPending = false;
 #else
 /* Default, let HAL calculate the prescaler*/
 static uint32_t predivAsync = RTC_AUTO_1_SECOND;
 #endif /* !STM32F1xx */
 
+/* nb of calendar register reads */
+static uint32_t calendarReadCount = 0;
+
 static hourFormat_t initFormat = HOUR_FORMAT_12;
 static binaryMode_t initMode = MODE_BINARY_NONE;
 
+#if defined(RTC_LSE_ASYNC_SUPPORT)
+/* Asynchronous LSE startup and LSE configuration kept while on LSI */
+static bool lseAsync = false;
+static bool lsePending = false;
+static uint32_t lseClkVal = LSE_VALUE;
+static bool lseClkConfigured = false;
+static uint32_t lsePredivAsync, lsePredivSync;
+static bool lsePredivComputed = true;
+#if defined(RTC_LSECSS_SUPPORT)
+/* LSE clock security system, and LSI fallback after an LSE failure */
+static bool lseCss = false;
+static bool lseFailed = false;
+/*
+ * Calendar and SysTick read together while the LSE runs, refreshed by a poll
+ * after RTC_LSE_REF_INTERVAL or once the calendar has been written
+ */
+static dateTime_t lseRefTime;
+static uint32_t lseRefTick = 0;
+static bool lseRefValid = false;
+/* The calendar has not been carried forward over the LSE outage */
+static bool lseTimeLost = false;
+static voidCallbackPtr RTCLseFailureCallback = NULL;
+static void *callbackLseFailureData = NULL;
+#endif /* RTC_LSECSS_SUPPORT */
+#endif /* RTC_LSE_ASYNC_SUPPORT */
+/*
+ * Backup registers saved and restored when the RTC clock source is switched,
+ * from RTC_BKP_FIRST to RTC_BKP_LAST (STM32F1xx: no LL_RTC_BKP_DR0)
+ */
+#if defined(STM32F1xx)
+#define RTC_BKP_FIRST LL_RTC_BKP_DR1
+#else
+#define RTC_BKP_FIRST LL_RTC_BKP_DR0
+#endif /* STM32F1xx */
+#if defined(RTC_BKP_NUMBER)
+#define RTC_BKP_LAST (RTC_BKP_FIRST + RTC_BKP_NUMBER - 1)
+#elif defined(LL_RTC_BKP_DR42)
+#define RTC_BKP_LAST LL_RTC_BKP_DR42
+#elif defined(LL_RTC_BKP_DR41)
+#define RTC_BKP_LAST LL_RTC_BKP_DR41
+#elif defined(LL_RTC_BKP_DR31)
+#define RTC_BKP_LAST LL_RTC_BKP_DR31
+#elif defined(LL_RTC_BKP_DR19)
+#define RTC_BKP_LAST LL_RTC_BKP_DR19
+#elif defined(LL_RTC_BKP_DR15)
+#define RTC_BKP_LAST LL_RTC_BKP_DR15
+#elif defined(LL_RTC_BKP_DR10)
+#define RTC_BKP_LAST LL_RTC_BKP_DR10
+#elif defined(LL_RTC_BKP_DR9)
+#define RTC_BKP_LAST LL_RTC_BKP_DR9
+#elif defined(LL_RTC_BKP_DR7)
+#define RTC_BKP_LAST LL_RTC_BKP_DR7
+#elif defined(LL_RTC_BKP_DR4)
+#define RTC_BKP_LAST LL_RTC_BKP_DR4
+#elif defined(LL_RTC_BKP_DR3)
+#define RTC_BKP_LAST LL_RTC_BKP_DR3
+#else
+#define RTC_BKP_LAST LL_RTC_BKP_DR1
+#endif /* RTC_BKP_NUMBER */
+#define RTC_BKP_SAVE_NB (RTC_BKP_LAST - RTC_BKP_FIRST + 1)
+
 /* Private function prototypes -----------------------------------------------*/
 static void RTC_initClock(sourceClock_t source);
+static uint32_t RTC_GetActiveClockSource(void);
 #if !defined(STM32F1xx)
 static void RTC_computePrediv(uint32_t *asynch, uint32_t *synch);
+static void RTC_setConversionFactors(uint32_t asynch, uint32_t synch);
+static bool RTC_FindPrediv(uint32_t ticksPerSecond, uint32_t *asynch, uint32_t *synch);
+static bool RTC_WritePrediv(uint32_t asynch, uint32_t synch);
+#if defined(RTC_LSI_TRIM_SUPPORT)
+static bool lsiTrim = false;
+static void RTC_LoadPrediv(void);
+#endif /* RTC_LSI_TRIM_SUPPORT */
 #endif /* !STM32F1xx */
 #if defined(RTC_BINARY_NONE)
 static void RTC_BinaryConf(binaryMode_t mode);
 static void RTC_SetBinaryConf(void);
 #endif
+#if defined(RTC_SSR_SS)
+static uint32_t RTC_SubSecondsToMs(uint32_t subSeconds);
+static uint32_t RTC_SubSecondsToTicks(uint32_t subSeconds);
+#endif /* RTC_SSR_SS */
+#if defined(RTC_BINARY_NONE)
+static uint32_t RTC_UpdateTicksWrap(void);
+#endif /* RTC_BINARY_NONE */
+#ifdef ONESECOND_IRQn
+static void RTC_EnableSecondsIrq(void);
+static void RTC_SecondsIrqHandled(void);
+#if !defined(STM32F1xx)
+static void RTC_WakeUpIRQHandler(void);
+#endif /* !STM32F1xx */
+#endif /* ONESECOND_IRQn */
+static bool RTC_SetPhase(uint32_t subSeconds);
+static bool RTC_ReadTime(uint8_t *hours, uint8_t *minutes, uint8_t *seconds, uint32_t *ssr, hourAM_PM_t *period);
+#if defined(RTC_CALIB_SUPPORT) && defined(RTC_BKP_CALIB)
+static void RTC_RestoreCalibration(void);
+#endif /* RTC_CALIB_SUPPORT && RTC_BKP_CALIB */
+#if defined(RTC_CALR_CALP)
+static int32_t RTC_CalibToPulses(uint32_t calr);
+#endif /* RTC_CALR_CALP */
+#if defined(RTC_SLEW_SUPPORT)
+static bool RTC_EndSlew(void);
+static void RTC_DisableSlewIrq(void);
+#endif /* RTC_SLEW_SUPPORT */
+#if !defined(STM32F1xx)
+static bool RTC_InitModeEnter(void);
+static void RTC_InitModeExit(void);
+static bool RTC_WarmInit(binaryMode_t mode, sourceClock_t source);
+#endif /* !STM32F1xx */
+static void RTC_initHardware(binaryMode_t mode, sourceClock_t source);
+static void RTC_SwitchClock(sourceClock_t source);
+#if defined(RTC_SHIFTR_SUBFS) || defined(RTC_LSECSS_SUPPORT)
+static uint64_t RTC_Y2kMs(const dateTime_t *dateTime);
+static void RTC_Y2kMsToDateTime(dateTime_t *dateTime, uint64_t y2kMs);
+#endif /* RTC_SHIFTR_SUBFS || RTC_LSECSS_SUPPORT */
+#if defined(RTC_SHIFTR_SUBFS)
+static inline bool RTC_IsSecondAhead(uint32_t ssr);
+static void RTC_SecondBack(dateTime_t *dateTime);
+#endif /* RTC_SHIFTR_SUBFS */
+#if defined(RTC_LSE_ASYNC_SUPPORT)
+static bool RTC_IsAlarmDue(alarm_t name, uint32_t from, uint32_t to);
+#endif /* RTC_LSE_ASYNC_SUPPORT */
+#if defined(RTC_LSECSS_SUPPORT)
+static void RTC_StartLseCss(void);
+static void RTC_SaveLseReference(void);
+static bool RTC_AdvanceTime(const dateTime_t *ref, uint32_t ms);
+#endif /* RTC_LSECSS_SUPPORT */
+#if defined(RTC_BKP_FINGERPRINT)
+static uint32_t RTC_Fingerprint(uint32_t asynch, uint32_t synch);
+static void RTC_SaveFingerprint(void);
+#endif /* RTC_BKP_FINGERPRINT */
+static void RTC_StartAlarmInternal(alarm_t name, uint8_t day, uint8_t hours, uint8_t minutes, uint8_t seconds,
+                                   uint64_t subSeconds, bool subSecondsInTicks, hourAM_PM_t period, uint8_t mask);
 
 static inline int _log2(int x)
 {
@@ -114,6 +302,11 @@ RTC_HandleTypeDef *RTC_GetHandle(void)
   return &RtcHandle;
 }
 
+#if defined(RCC_RTCCLKSOURCE_HSE_DIV31) && !defined(RCC_RTCCLKSOURCE_HSE_DIVX)
+/* Not defined for STM32F2xx */
+#define RCC_RTCCLKSOURCE_HSE_DIVX 0x00000300U
+#endif /* RCC_RTCCLKSOURCE_HSE_DIV31 && !RCC_RTCCLKSOURCE_HSE_DIVX */
+
 /**
   * @brief Set RTC clock source
   * @param source: RTC clock source: LSE, LSI or HSE
@@ -122,6 +315,7 @@ RTC_HandleTypeDef *RTC_GetHandle(void)
 void RTC_SetClockSource(sourceClock_t source)
 {
   clkSrc = source;
+  clkConfigured = false;
   if (source == LSE_CLOCK) {
     clkVal = LSE_VALUE;
 #if defined(LL_RCC_LSCO_CLKSOURCE_HSI64M_DIV2048)
@@ -133,42 +327,11 @@ void RTC_SetClockSource(sourceClock_t source)
 #else
   } else if (source == HSE_CLOCK) {
     /* HSE division factor for RTC clock must be define to ensure that
-     * the clock supplied to the RTC is less than or equal to 1 MHz
+     * the clock supplied to the RTC is less than or equal to 1 MHz.
+     * Computed at build time from HSE_VALUE.
      */
-#if defined(STM32F1xx)
-    /* HSE max is 16 MHZ divided by 128 --> 125 KHz */
-    HSEDiv = 128;
-#elif defined(RCC_RTCCLKSOURCE_HSE_DIV32) && !defined(RCC_RTCCLKSOURCE_HSE_DIV31)
-    HSEDiv = 32;
-#elif !defined(RCC_RTCCLKSOURCE_HSE_DIV31)
-    if ((HSE_VALUE / 2) <= HSE_RTC_MAX) {
-      HSEDiv = 2;
-    } else if ((HSE_VALUE / 4) <= HSE_RTC_MAX) {
-      HSEDiv = 4;
-    } else if ((HSE_VALUE / 8) <= HSE_RTC_MAX) {
-      HSEDiv = 8;
-    } else if ((HSE_VALUE / 16) <= HSE_RTC_MAX) {
-      HSEDiv = 16;
-    }
-#elif defined(RCC_RTCCLKSOURCE_HSE_DIV31)
-    /* Not defined for STM32F2xx */
-#ifndef RCC_RTCCLKSOURCE_HSE_DIVX
-#define RCC_RTCCLKSOURCE_HSE_DIVX 0x00000300U
-#endif /* RCC_RTCCLKSOURCE_HSE_DIVX */
-#if defined(RCC_RTCCLKSOURCE_HSE_DIV63)
-#define HSEDIV_MAX 64
-#else
-#define HSEDIV_MAX 32
-#endif
-    for (HSEDiv = 2; HSEDiv < HSEDIV_MAX; HSEDiv++) {
-      if ((HSE_VALUE / HSEDiv) <= HSE_RTC_MAX) {
-        break;
-      }
-    }
-#else
-#error "Could not define HSE div"
-#endif /* STM32F1xx */
-    if ((HSE_VALUE / HSEDiv) > HSE_RTC_MAX) {
+    HSEDiv = RTC_HSE_DIV(HSE_VALUE);
+    if (((HSE_VALUE / HSEDiv) > HSE_RTC_MAX) || (HSEDiv > RTC_HSE_DIV_MAX)) {
       Error_Handler();
     }
     clkVal = HSE_VALUE / HSEDiv;
@@ -180,6 +343,28 @@ void RTC_SetClockSource(sourceClock_t source)
   }
 }
 
+/**
+  * @brief Set RTC clock source with its frequency and the prescalers
+  *        computed at build time (see STM32RTC::Config), no computation is done.
+  * @param source: RTC clock source: LSE, LSI or HSE
+  * @param clock: RTC clock frequency in Hz (HSE: divided by RTC_HSE_DIV(HSE_VALUE))
+  * @param asynch: asynchronous prescaler value
+  * @param synch: synchronous prescaler value, not used for STM32F1xx series.
+  * @retval None
+  */
+void RTC_SetClockConfig(sourceClock_t source, uint32_t clock, uint32_t asynch, uint32_t synch)
+{
+  clkSrc = source;
+  clkVal = clock;
+  clkConfigured = true;
+#if !defined(LL_RCC_LSCO_CLKSOURCE_HSI64M_DIV2048)
+  if (source == HSE_CLOCK) {
+    HSEDiv = RTC_HSE_DIV(HSE_VALUE);
+  }
+#endif
+  RTC_setPrediv(asynch, synch);
+}
+
 /**
   * @brief RTC clock initialization
   *        This function configures the hardware resources used.
@@ -193,7 +378,9 @@ void RTC_SetClockSource(sourceClock_t source)
 static void RTC_initClock(sourceClock_t source)
 {
   RCC_PeriphCLKInitTypeDef PeriphClkInit;
-  RTC_SetClockSource(source);
+  if (!clkConfigured || (source != clkSrc)) {
+    RTC_SetClockSource(source);
+  }
   if (source == LSE_CLOCK) {
     /* Enable the clock if not already set by user */
     enableClock(LSE_CLOCK);
@@ -278,6 +465,44 @@ static void RTC_initClock(sourceClock_t source)
 #endif
 }
 
+/**
+  * @brief Get the clock source currently selected for the RTC in the RCC
+  * @retval LSE_CLOCK, LSI_CLOCK, HSE_CLOCK or HSI_CLOCK, 0xFFFFFFFF if none
+  */
+static uint32_t RTC_GetActiveClockSource(void)
+{
+#if defined(__HAL_RCC_GET_RTC_WDG_BLEWKUP_CLK_CONFIG)
+  uint32_t source = __HAL_RCC_GET_RTC_WDG_BLEWKUP_CLK_CONFIG();
+  return ((source == RCC_RTC_WDG_BLEWKUP_CLKSOURCE_LSE) ? LSE_CLOCK :
+          (source == RCC_RTC_WDG_BLEWKUP_CLKSOURCE_LSI) ? LSI_CLOCK :
+          (source == RCC_RTC_WDG_BLEWKUP_CLKSOURCE_HSI64M_DIV2048) ? HSI_CLOCK :
+          // default case corresponding to no clock source
+          0xFFFFFFFF);
+#elif defined(__HAL_RCC_GET_RTC_SUBG_LPAWUR_LCD_LCSC_CLK_CONFIG)
+  uint32_t source = __HAL_RCC_GET_RTC_SUBG_LPAWUR_LCD_LCSC_CLK_CONFIG();
+  return ((source == RCC_RTC_WDG_SUBG_LPAWUR_LCD_LCSC_CLKSOURCE_LSE) ? LSE_CLOCK :
+          (source == RCC_RTC_WDG_SUBG_LPAWUR_LCD_LCSC_CLKSOURCE_LSI) ? LSI_CLOCK :
+          (source == RCC_RTC_WDG_SUBG_LPAWUR_LCD_LCSC_CLKSOURCE_DIV512) ? HSI_CLOCK :
+          // default case corresponding to no clock source
+          0xFFFFFFFF);
+#else
+  uint32_t source = __HAL_RCC_GET_RTC_SOURCE();
+  return ((source == RCC_RTCCLKSOURCE_LSE) ? LSE_CLOCK :
+          (source == RCC_RTCCLKSOURCE_LSI) ? LSI_CLOCK :
+#if defined(RCC_RTCCLKSOURCE_HSE_DIVX)
+          (source == RCC_RTCCLKSOURCE_HSE_DIVX) ? HSE_CLOCK :
+#elif defined(RCC_RTCCLKSOURCE_HSE_DIV32)
+          (source == RCC_RTCCLKSOURCE_HSE_DIV32) ? HSE_CLOCK :
+#elif defined(RCC_RTCCLKSOURCE_HSE_DIV)
+          (source == RCC_RTCCLKSOURCE_HSE_DIV) ? HSE_CLOCK :
+#elif defined(RCC_RTCCLKSOURCE_HSE_DIV128)
+          (source == RCC_RTCCLKSOURCE_HSE_DIV128) ? HSE_CLOCK :
+#endif
+          // default case corresponding to no clock source
+          0xFFFFFFFF);
+#endif
+}
+
 /**
   * @brief set user (a)synchronous prescaler values.
   * @param asynch: asynchronous prescaler value in range 0 - PREDIVA_MAX
@@ -300,10 +525,13 @@ void RTC_setPrediv(uint32_t asynch, uint32_t synch)
   if ((asynch <= PREDIVA_MAX) && (synch <= PREDIVS_MAX)) {
     predivAsync = asynch;
     predivSync = synch;
+    predivComputed = false;
   } else {
     RTC_computePrediv(&predivAsync, &predivSync);
+    predivComputed = true;
   }
   predivSync_bits = (uint8_t)_log2(predivSync) + 1;
+  RTC_setConversionFactors(predivAsync, predivSync);
 #endif /* STM32F1xx */
 }
 
@@ -337,6 +565,7 @@ void RTC_getPrediv(uint32_t *asynch, uint32_t *synch)
     *synch = predivSync;
   }
   predivSync_bits = (uint8_t)_log2(predivSync) + 1;
+  RTC_setConversionFactors(predivAsync, predivSync);
 #endif /* STM32F1xx */
 }
 
@@ -344,14 +573,14 @@ void RTC_getPrediv(uint32_t *asynch, uint32_t *synch)
 /**
   * @brief Compute (a)synchronous prescaler
   *        RTC prescalers are compute to obtain the RTC clock to 1Hz. See AN4759.
+  * @note  Only computed: the conversion factors are updated by the caller.
   * @param asynch: pointer where return asynchronous prescaler value.
   * @param synch: pointer where return synchronous prescaler value.
   * @retval None
   */
 static void RTC_computePrediv(uint32_t *asynch, uint32_t *synch)
 {
-  uint32_t predivS = PREDIVS_MAX + 1;
-  *asynch = PREDIVA_MAX + 1;
+  uint32_t predivS;
 
   /* Get user predividers if manually configured */
   if ((asynch == NULL) || (synch == NULL)) {
@@ -359,31 +588,164 @@ static void RTC_computePrediv(uint32_t *asynch, uint32_t *synch)
   }
 
   /* Find (a)synchronous prescalers to obtain the 1Hz calendar clock */
-  do {
-    (*asynch)--;
-    predivS = (clkVal / (*asynch + 1)) - 1;
+  *asynch = RTC_ComputePredivA(clkVal, PREDIVA_MAX, PREDIVS_MAX);
+  predivS = (clkVal / (*asynch + 1)) - 1;
+
+  if (!IS_RTC_SYNCH_PREDIV(predivS)) {
+    Error_Handler();
+  }
+  *synch = predivS;
+}
 
-    if (((predivS + 1) * (*asynch + 1)) == clkVal) {
-      break;
+/**
+  * @brief Find the prescalers giving a 1Hz calendar clock with the nearest
+  *        SubSecond resolution, the lowest power one if several are as near.
+  * @param ticksPerSecond: requested nb of SubSecond ticks per second
+  * @param asynch: pointer where return asynchronous prescaler value.
+  * @param synch: pointer where return synchronous prescaler value.
+  * @retval True if found else false
+  */
+static bool RTC_FindPrediv(uint32_t ticksPerSecond, uint32_t *asynch, uint32_t *synch)
+{
+  uint32_t bestDelta = UINT32_MAX;
+
+  /* From the highest asynchronous prescaler: the lowest power first */
+  for (uint32_t a = PREDIVA_MAX + 1; a != 0; a--) {
+    uint32_t s = clkVal / a;
+    if (((s * a) == clkVal) && (s != 0) && ((s - 1) <= PREDIVS_MAX)) {
+      uint32_t delta = (s > ticksPerSecond) ? (s - ticksPerSecond) : (ticksPerSecond - s);
+      if (delta < bestDelta) {
+        bestDelta = delta;
+        *asynch = a - 1;
+        *synch = s - 1;
+      }
     }
-  } while (*asynch != 0);
+  }
+  return (bestDelta != UINT32_MAX);
+}
 
-  /*
-   * Can't find a 1Hz, so give priority to RTC power consumption
-   * by choosing the higher possible value for predivA
-   */
-  if ((!IS_RTC_SYNCH_PREDIV(predivS)) || (!IS_RTC_ASYNCH_PREDIV(*asynch))) {
-    *asynch = PREDIVA_MAX;
-    predivS = (clkVal / (*asynch + 1)) - 1;
+/**
+  * @brief Set the prescalers, written in the RTC if already initialized by
+  *        RTC_init(), else only stored and written by the next RTC_init()
+  * @note  The current time is kept, the prescalers are written in the
+  *        initialization mode. Not possible while running in BIN or MIX mode.
+  *        Nothing is changed if the initialization mode can't be entered.
+  * @param asynch: asynchronous prescaler value
+  * @param synch: synchronous prescaler value
+  * @retval True if set else false
+  */
+static bool RTC_WritePrediv(uint32_t asynch, uint32_t synch)
+{
+  bool running = rtcInitialized;
+  uint32_t subSeconds = 0;
+
+  if ((asynch == predivAsync) && (synch == predivSync)) {
+    return true;
+  }
+  if (running) {
+#if defined(RTC_SHIFTR_SUBFS)
+    dateTime_t dateTime;
+    bool ahead;
+#else
+    hourAM_PM_t period;
+    uint8_t hours, minutes, seconds;
+#endif /* RTC_SHIFTR_SUBFS */
+    if (initMode != MODE_BINARY_NONE) {
+      return false;
+    }
+    /* Read with the conversion factors of the current prescalers */
+#if defined(RTC_SHIFTR_SUBFS)
+    ahead = RTC_IsSecondAhead(READ_REG(RtcHandle.Instance->SSR));
+    RTC_GetDateTime(&dateTime);
+    subSeconds = dateTime.subSeconds;
+#else
+    RTC_GetTime(&hours, &minutes, &seconds, &subSeconds, &period);
+#endif /* RTC_SHIFTR_SUBFS */
+    __HAL_RTC_WRITEPROTECTION_DISABLE(&RtcHandle);
+    if (!RTC_InitModeEnter()) {
+      __HAL_RTC_WRITEPROTECTION_ENABLE(&RtcHandle);
+      return false;
+    }
+    LL_RTC_SetSynchPrescaler(RtcHandle.Instance, synch);
+    LL_RTC_SetAsynchPrescaler(RtcHandle.Instance, asynch);
+#if defined(RTC_SHIFTR_SUBFS)
+    if (ahead) {
+      /* The SubSecond register restarts: take back the second given by a pending delay */
+      WRITE_REG(RtcHandle.Instance->TR, RTC_PackTime(dateTime.hours, dateTime.minutes, dateTime.seconds,
+                                                     (initFormat == HOUR_FORMAT_12) && (dateTime.period == HOUR_PM)));
+      WRITE_REG(RtcHandle.Instance->DR, RTC_PackDate(dateTime.year, dateTime.month, dateTime.day, dateTime.wday));
+    }
+#endif /* RTC_SHIFTR_SUBFS */
+    RTC_InitModeExit();
+    __HAL_RTC_WRITEPROTECTION_ENABLE(&RtcHandle);
+  }
+  /* Written (or to be written by RTC_init()): commit the new prescalers */
+  predivPending = !running;
+  predivAsync = asynch;
+  predivSync = synch;
+  predivSync_bits = (uint8_t)_log2(predivSync) + 1;
+  RtcHandle.Init.AsynchPrediv = asynch;
+  RtcHandle.Init.SynchPrediv = synch;
+  RTC_setConversionFactors(asynch, synch);
+  if (running) {
+    /* The prescalers restart: restore the subsecond phase */
+    RTC_SetPhase(subSeconds);
+#if defined(RTC_BKP_FINGERPRINT)
+    RTC_SaveFingerprint();
+#endif /* RTC_BKP_FINGERPRINT */
   }
+  return true;
+}
 
-  if (!IS_RTC_SYNCH_PREDIV(predivS)) {
-    Error_Handler();
+/**
+  * @brief Set the prescalers giving the nearest SubSecond resolution to the
+  *        requested one with a 1Hz calendar clock. The lowest resolution
+  *        gives the lowest RTC power consumption.
+  * @note  Can be called before or after the RTC initialization (BCD mode).
+  * @param ticksPerSecond: requested nb of SubSecond ticks per second
+  * @retval Achieved nb of SubSecond ticks per second, 0 if not set
+  */
+uint32_t RTC_SetSubSecondResolution(uint32_t ticksPerSecond)
+{
+  uint32_t asynch, synch;
+
+  if (!RTC_FindPrediv(ticksPerSecond, &asynch, &synch) || !RTC_WritePrediv(asynch, synch)) {
+    return 0;
   }
-  *synch = predivS;
+  predivComputed = false;
+  return synch + 1;
+}
+
+/**
+  * @brief Estimate the part of the RTC current depending on the prescalers:
+  *        the SubSecond counter clock relative to the lowest power prescalers.
+  * @retval Relative current in percent, 100 for the lowest power
+  */
+uint32_t RTC_GetRelativeCurrent(void)
+{
+  uint32_t asynch, synch;
+
+  if (!RTC_FindPrediv(1, &asynch, &synch)) {
+    return 100;
+  }
+  return ((asynch + 1) * 100) / (predivAsync + 1);
+}
 
-  fqce_apre = clkVal / (*asynch + 1);
+/**
+  * @brief Update the conversion factors of the SubSecond register
+  *        Q32 reciprocals are precomputed here, when prescalers change,
+  *        so the conversions only use multiply and shift.
+  * @param asynch: asynchronous prescaler value
+  * @param synch: synchronous prescaler value
+  * @retval None
+  */
+static void RTC_setConversionFactors(uint32_t asynch, uint32_t synch)
+{
+  fqce_apre = clkVal / (asynch + 1);
+  fqce_apre_recip = (fqce_apre != 0) ? (UINT32_MAX / fqce_apre) : 0;
+  predivSync_recip = UINT32_MAX / (synch + 1);
 }
+
 #endif /* !STM32F1xx */
 
 #if defined(RTC_BINARY_NONE)
@@ -393,26 +755,11 @@ static void RTC_BinaryConf(binaryMode_t mode)
   if (RtcHandle.Init.BinMode == RTC_BINARY_MIX) {
     /* Configure the 1s BCD calendar increment */
 
-    uint32_t inc = 1 / (1.0 / ((float)clkVal / (float)(predivAsync + 1.0)));
-    if (inc <= 256) {
-      RtcHandle.Init.BinMixBcdU = RTC_BINARY_MIX_BCDU_0;
-    } else if (inc < (256 << 1)) {
-      RtcHandle.Init.BinMixBcdU = RTC_BINARY_MIX_BCDU_1;
-    } else if (inc < (256 << 2)) {
-      RtcHandle.Init.BinMixBcdU = RTC_BINARY_MIX_BCDU_2;
-    } else if (inc < (256 << 3)) {
-      RtcHandle.Init.BinMixBcdU = RTC_BINARY_MIX_BCDU_3;
-    } else if (inc < (256 << 4)) {
-      RtcHandle.Init.BinMixBcdU = RTC_BINARY_MIX_BCDU_4;
-    } else if (inc < (256 << 5)) {
-      RtcHandle.Init.BinMixBcdU = RTC_BINARY_MIX_BCDU_5;
-    } else if (inc < (256 << 6)) {
-      RtcHandle.Init.BinMixBcdU = RTC_BINARY_MIX_BCDU_6;
-    } else if (inc < (256 << 7)) {
-      RtcHandle.Init.BinMixBcdU = RTC_BINARY_MIX_BCDU_7;
-    } else {
+    uint32_t bcdu = RTC_BinMixBcdU(clkVal / (predivAsync + 1));
+    if (bcdu == 0xFFU) {
       Error_Handler();
     }
+    RtcHandle.Init.BinMixBcdU = bcdu << RTC_ICSR_BCDU_Pos;
   }
 }
 
@@ -429,6 +776,9 @@ static void RTC_BinaryConf(binaryMode_t mode)
 #if (RTC_BINARY_MIX_BCDU_7 != LL_RTC_BINARY_MIX_BCDU_7)
 #error "RTC_BINARY_MIX_BCDU_n and LL_RTC_BINARY_MIX_BCDU_n do not match"
 #endif
+#if (RTC_BINARY_MIX_BCDU_1 != (1UL << RTC_ICSR_BCDU_Pos)) || (RTC_BINARY_MIX_BCDU_7 != (7UL << RTC_ICSR_BCDU_Pos))
+#error "RTC_BINARY_MIX_BCDU_n is not the BCDU value n in RTC_ICSR"
+#endif
 static void RTC_SetBinaryConf(void)
 {
   if (LL_RTC_GetBinaryMode(RtcHandle.Instance) != RtcHandle.Init.BinMode) {
@@ -445,6 +795,184 @@ static void RTC_SetBinaryConf(void)
 }
 #endif /* RTC_BINARY_NONE */
 
+#if !defined(STM32F1xx)
+/**
+  * @brief Warm boot fast path of RTC_init()
+  *        When the RTC already runs from the requested clock source with the
+  *        expected prescalers, hour format and binary mode, only the RAM state
+  *        is restored: registers are read, neither the RCC nor the RTC is written.
+  * @param mode: requested BCD, Mix or Binary mode
+  * @param source: requested RTC clock source: LSE, LSI or HSI
+  * @note  HSE is excluded as its RTC prescaler is cleared by a system reset.
+  * @retval True if the running configuration was kept, else false
+  */
+static bool RTC_WarmInit(binaryMode_t mode, sourceClock_t source)
+{
+#if defined(__HAL_RCC_RTC_CLK_ENABLE)
+  __HAL_RCC_RTC_CLK_ENABLE();
+#endif
+  if (source == HSE_CLOCK) {
+    return false;
+  }
+  /* Not initialized, or not from the requested clock: the cold path configures it */
+  if (!LL_RTC_IsActiveFlag_INITS(RtcHandle.Instance)
+      || (RTC_GetActiveClockSource() != (uint32_t)source)) {
+    return false;
+  }
+  if (!clkConfigured || (source != clkSrc)) {
+    RTC_SetClockSource(source);
+  }
+#if defined(RTC_BKP_FINGERPRINT)
+  uint32_t asynch = predivAsync, synch = predivSync;
+  if ((!IS_RTC_SYNCH_PREDIV(synch)) || (!IS_RTC_ASYNCH_PREDIV(asynch))) {
+    RTC_computePrediv(&asynch, &synch);
+  }
+  if (getBackupRegister(RTC_BKP_FINGERPRINT) == RTC_Fingerprint(asynch, synch)) {
+    /*
+     * Initialized from the requested clock, and configured by this library
+     * with the same settings: no other register needs to be probed.
+     */
+    predivAsync = asynch;
+    predivSync = synch;
+    RTC_getPrediv(&(RtcHandle.Init.AsynchPrediv), &(RtcHandle.Init.SynchPrediv));
+#if defined(RTC_LSI_TRIM_SUPPORT)
+    if (lsiTrim) {
+      RTC_LoadPrediv();
+    }
+#endif /* RTC_LSI_TRIM_SUPPORT */
+#if defined(RTC_BINARY_NONE)
+    RTC_BinaryConf(mode);
+#else
+    UNUSED(mode);
+#endif /* RTC_BINARY_NONE */
+    enableClock(source);
+    return true;
+  }
+#endif /* RTC_BKP_FINGERPRINT */
+  if (LL_RTC_GetHourFormat(RtcHandle.Instance) != RtcHandle.Init.HourFormat) {
+    return false;
+  }
+#if defined(RTC_CR_BYPSHAD)
+  if (!LL_RTC_IsShadowRegBypassEnabled(RtcHandle.Instance)) {
+    return false;
+  }
+#endif
+  RTC_getPrediv(&(RtcHandle.Init.AsynchPrediv), &(RtcHandle.Init.SynchPrediv));
+#if defined(RTC_LSI_TRIM_SUPPORT)
+  if (lsiTrim) {
+    RTC_LoadPrediv();
+  }
+#endif /* RTC_LSI_TRIM_SUPPORT */
+  if ((LL_RTC_GetAsynchPrescaler(RtcHandle.Instance) != predivAsync)
+      || (LL_RTC_GetSynchPrescaler(RtcHandle.Instance) != predivSync)) {
+    return false;
+  }
+#if defined(RTC_BINARY_NONE)
+  RTC_BinaryConf(mode);
+  if ((LL_RTC_GetBinaryMode(RtcHandle.Instance) != RtcHandle.Init.BinMode)
+      || ((RtcHandle.Init.BinMode == RTC_BINARY_MIX)
+          && (LL_RTC_GetBinMixBCDU(RtcHandle.Instance) != RtcHandle.Init.BinMixBcdU))) {
+    return false;
+  }
+#else
+  UNUSED(mode);
+#endif /* RTC_BINARY_NONE */
+#if defined(RTC_BKP_FINGERPRINT)
+  RTC_SaveFingerprint();
+#endif /* RTC_BKP_FINGERPRINT */
+  /*
+   * The LSI is stopped by a system reset while the RTC keeps its selection:
+   * enableClock() restarts it and waits until it is ready.
+   */
+  enableClock(source);
+  return true;
+}
+#endif /* !STM32F1xx */
+
+#if defined(RTC_BKP_FINGERPRINT)
+/* Revision of the configuration sequence, to bump when it changes */
+#define RTC_FINGERPRINT_REV 1U
+
+/**
+  * @brief Compute the fingerprint of the RTC configuration
+  *        FNV-1a hash of the clock source and frequency, the prescalers, the
+  *        hour format, the binary mode, the saved calibration and the revision
+  *        of the configuration sequence.
+  * @param asynch: asynchronous prescaler value
+  * @param synch: synchronous prescaler value
+  * @retval Fingerprint, never 0 (backup register reset value)
+  */
+static uint32_t RTC_Fingerprint(uint32_t asynch, uint32_t synch)
+{
+  uint32_t config[8] = { RTC_FINGERPRINT_REV, clkSrc, clkVal, asynch, synch,
+                         RtcHandle.Init.HourFormat, initMode, 0
+                       };
+
+#if defined(RTC_LSI_TRIM_SUPPORT)
+  if (lsiTrim && (clkSrc == LSI_CLOCK) && predivComputed) {
+    /* Measured prescalers, read back on warm start */
+    config[2] = config[3] = config[4] = 0;
+  }
+#endif /* RTC_LSI_TRIM_SUPPORT */
+#if defined(RTC_CALIB_SUPPORT) && defined(RTC_BKP_CALIB)
+  config[7] = getBackupRegister(RTC_BKP_CALIB);
+#endif /* RTC_CALIB_SUPPORT && RTC_BKP_CALIB */
+  return RTC_HashConfig(config, 8);
+}
+
+/**
+  * @brief Save the fingerprint of the current RTC configuration
+  * @retval None
+  */
+static void RTC_SaveFingerprint(void)
+{
+  uint32_t fingerprint = RTC_Fingerprint(predivAsync, predivSync);
+
+  if (getBackupRegister(RTC_BKP_FINGERPRINT) != fingerprint) {
+    setBackupRegister(RTC_BKP_FINGERPRINT, fingerprint);
+  }
+}
+#endif /* RTC_BKP_FINGERPRINT */
+
+/**
+  * @brief Initialize the RTC clock and registers of a RTC not initialized
+  *        (first init or backup domain reset), the calendar is not set.
+  * @param mode: BCD, MIX or BIN mode
+  * @param source: RTC clock source: LSE, LSI or HSE
+  * @retval None
+  */
+static void RTC_initHardware(binaryMode_t mode, sourceClock_t source)
+{
+  // Init RTC clock
+  RTC_initClock(source);
+#if defined(STM32F1xx)
+  UNUSED(mode);
+  RtcHandle.Init.AsynchPrediv = predivAsync;
+#else
+  RTC_getPrediv(&(RtcHandle.Init.AsynchPrediv), &(RtcHandle.Init.SynchPrediv));
+#if defined(RTC_BINARY_NONE)
+  /*
+   * If RTC BIN mode changed, calling the HAL_RTC_Init will
+   * force the update of the BIN register in the RTC_ICSR
+   */
+  RTC_BinaryConf(mode);
+#else
+  UNUSED(mode);
+#endif /* RTC_BINARY_NONE */
+#endif  // STM32F1xx
+
+  HAL_RTC_Init(&RtcHandle);
+#if !defined(STM32F1xx)
+  rtcInitialized = true;
+  predivPending = false;
+#endif /* !STM32F1xx */
+#if defined(RTC_LSI_TRIM_SUPPORT)
+  if (lsiTrim) {
+    RTC_TrimLsi();
+  }
+#endif /* RTC_LSI_TRIM_SUPPORT */
+}
+
 /**
   * @brief RTC Initialization
   *        This function configures the RTC time and calendar. By default, the
@@ -459,16 +987,8 @@ static void RTC_SetBinaryConf(void)
 bool RTC_init(hourFormat_t format, binaryMode_t mode, sourceClock_t source, bool reset)
 {
   bool reinit = false;
-  hourAM_PM_t period = HOUR_AM, alarmPeriod = HOUR_AM;
-  uint32_t subSeconds = 0, alarmSubseconds = 0;
-  uint8_t seconds = 0, minutes = 0, hours = 0, weekDay = 0, days = 0, month = 0, years = 0;
-  uint8_t alarmMask = 0, alarmDay = 0, alarmHours = 0, alarmMinutes = 0, alarmSeconds = 0;
-  bool isAlarmASet = false;
-#ifdef RTC_ALARM_B
-  hourAM_PM_t alarmBPeriod = HOUR_AM;
-  uint8_t alarmBMask = 0, alarmBDay = 0, alarmBHours = 0, alarmBMinutes = 0, alarmBSeconds = 0;
-  uint32_t alarmBSubseconds = 0;
-  bool isAlarmBSet = false;
+#if defined(STM32F1xx)
+  uint8_t weekDay = 0, days = 0, month = 0, years = 0;
 #endif
 
   initFormat = format;
@@ -506,70 +1026,64 @@ bool RTC_init(hourFormat_t format, binaryMode_t mode, sourceClock_t source, bool
 #ifdef __HAL_RCC_RTC_ENABLE
   __HAL_RCC_RTC_ENABLE();
 #endif
-  isAlarmASet = RTC_IsAlarmSet(ALARM_A);
-#ifdef RTC_ALARM_B
-  isAlarmBSet = RTC_IsAlarmSet(ALARM_B);
-#endif
+#if defined(RTC_LSE_ASYNC_SUPPORT)
+  if (lseAsync && (source == LSE_CLOCK) && !lsePending
+      && (!RTC_IsLseReady() || (LL_RTC_IsActiveFlag_INITS(RtcHandle.Instance)
+                                && (RTC_GetActiveClockSource() == LSI_CLOCK)))) {
+    /*
+     * Switching to the LSE resets the backup domain and waits for the LSE:
+     * start it without waiting and run from the LSI until RTC_HandoverLse()
+     */
+    __HAL_RCC_LSE_CONFIG(RCC_LSE_ON);
+    lseClkVal = clkVal;
+    lseClkConfigured = clkConfigured;
+    lsePredivAsync = predivAsync;
+    lsePredivSync = predivSync;
+    lsePredivComputed = predivComputed;
+    RTC_SetClockSource(LSI_CLOCK);
+    RTC_setPrediv(PREDIVA_MAX + 1, PREDIVS_MAX + 1);
+    lsePending = true;
+  }
+  if (lsePending) {
+    source = LSI_CLOCK;
+  }
+#if defined(RTC_LSECSS_SUPPORT)
+  if (lseFailed) {
+    source = LSI_CLOCK;
+  }
+#endif /* RTC_LSECSS_SUPPORT */
+#endif /* RTC_LSE_ASYNC_SUPPORT */
+#if !defined(STM32F1xx)
+  if (!reset && RTC_WarmInit(mode, source)) {
+    // RTC already runs with the requested configuration, nothing to write
+    rtcInitialized = true;
+    predivPending = false;
+#if defined(RTC_LSECSS_SUPPORT)
+    RTC_StartLseCss();
+#endif /* RTC_LSECSS_SUPPORT */
+    return reinit;
+  }
+#endif /* !STM32F1xx */
 #if defined(STM32F1xx)
   uint32_t BackupDate;
   BackupDate = getBackupRegister(RTC_BKP_DATE) << 16;
   BackupDate |= getBackupRegister(RTC_BKP_DATE + 1) & 0xFFFF;
   if ((BackupDate == 0) || reset) {
-    // RTC needs initialization
-    // Init RTC clock
-    RTC_initClock(source);
 #else
   if (!LL_RTC_IsActiveFlag_INITS(RtcHandle.Instance) || reset) {
-    // RTC needs initialization
-    // Init RTC clock
-    RTC_initClock(source);
-    RTC_getPrediv(&(RtcHandle.Init.AsynchPrediv), &(RtcHandle.Init.SynchPrediv));
-#if defined(RTC_BINARY_NONE)
-    /*
-     * If RTC BIN mode changed, calling the HAL_RTC_Init will
-     * force the update of the BIN register in the RTC_ICSR
-     */
-    RTC_BinaryConf(mode);
-#endif /* RTC_BINARY_NONE */
 #endif  // STM32F1xx
-
-    HAL_RTC_Init(&RtcHandle);
+    // RTC needs initialization
+    RTC_initHardware(mode, source);
+#if defined(RTC_CALIB_SUPPORT) && defined(RTC_BKP_CALIB)
+    RTC_RestoreCalibration();
+#endif /* RTC_CALIB_SUPPORT && RTC_BKP_CALIB */
     // Default: saturday 1st of January 2001
     // Note: year 2000 is invalid as it is the hardware reset value and doesn't raise INITS flag
     RTC_SetDate(1, 1, 1, 6);
     reinit = true;
   } else {
     // RTC is already initialized
-#if defined(__HAL_RCC_GET_RTC_WDG_BLEWKUP_CLK_CONFIG)
-    uint32_t oldRtcClockSource = __HAL_RCC_GET_RTC_WDG_BLEWKUP_CLK_CONFIG();
-    oldRtcClockSource = ((oldRtcClockSource == RCC_RTC_WDG_BLEWKUP_CLKSOURCE_LSE) ? LSE_CLOCK :
-                         (oldRtcClockSource == RCC_RTC_WDG_BLEWKUP_CLKSOURCE_LSI) ? LSI_CLOCK :
-                         (oldRtcClockSource == RCC_RTC_WDG_BLEWKUP_CLKSOURCE_HSI64M_DIV2048) ? HSI_CLOCK :
-                         // default case corresponding to no clock source
-                         0xFFFFFFFF);
-#elif defined(__HAL_RCC_GET_RTC_SUBG_LPAWUR_LCD_LCSC_CLK_CONFIG)
-    uint32_t oldRtcClockSource = __HAL_RCC_GET_RTC_SUBG_LPAWUR_LCD_LCSC_CLK_CONFIG();
-    oldRtcClockSource = ((oldRtcClockSource == RCC_RTC_WDG_SUBG_LPAWUR_LCD_LCSC_CLKSOURCE_LSE) ? LSE_CLOCK :
-                         (oldRtcClockSource == RCC_RTC_WDG_SUBG_LPAWUR_LCD_LCSC_CLKSOURCE_LSI) ? LSI_CLOCK :
-                         (oldRtcClockSource == RCC_RTC_WDG_SUBG_LPAWUR_LCD_LCSC_CLKSOURCE_DIV512) ? HSI_CLOCK :
-                         // default case corresponding to no clock source
-                         0xFFFFFFFF);
-#else
-    uint32_t oldRtcClockSource = __HAL_RCC_GET_RTC_SOURCE();
-    oldRtcClockSource = ((oldRtcClockSource == RCC_RTCCLKSOURCE_LSE) ? LSE_CLOCK :
-                         (oldRtcClockSource == RCC_RTCCLKSOURCE_LSI) ? LSI_CLOCK :
-#if defined(RCC_RTCCLKSOURCE_HSE_DIVX)
-                         (oldRtcClockSource == RCC_RTCCLKSOURCE_HSE_DIVX) ? HSE_CLOCK :
-#elif defined(RCC_RTCCLKSOURCE_HSE_DIV32)
-                         (oldRtcClockSource == RCC_RTCCLKSOURCE_HSE_DIV32) ? HSE_CLOCK :
-#elif defined(RCC_RTCCLKSOURCE_HSE_DIV)
-                         (oldRtcClockSource == RCC_RTCCLKSOURCE_HSE_DIV) ? HSE_CLOCK :
-#elif defined(RCC_RTCCLKSOURCE_HSE_DIV128)
-                         (oldRtcClockSource == RCC_RTCCLKSOURCE_HSE_DIV128) ? HSE_CLOCK :
-#endif
-                         // default case corresponding to no clock source
-                         0xFFFFFFFF);
-#endif
+    uint32_t oldRtcClockSource = RTC_GetActiveClockSource();
 #if defined(STM32F1xx)
     if ((RtcHandle.DateToUpdate.WeekDay == 0)
         && (RtcHandle.DateToUpdate.Month == 0)
@@ -581,62 +1095,37 @@ bool RTC_init(hourFormat_t format, binaryMode_t mode, sourceClock_t source, bool
 #endif  // STM32F1xx
 
     if (source != oldRtcClockSource) {
-      // RTC is already initialized, but RTC clock source is changed
-      // In case of RTC source clock change, Backup Domain is reset by RTC_initClock()
-      // Save current config before reinit
-      RTC_GetDate(&years, &month, &days, &weekDay);
-      RTC_GetTime(&hours, &minutes, &seconds, &subSeconds, &period);
-      // As clock source changed, force update prediv with user or computef ones
-#if defined(STM32F1xx)
-      RTC_setPrediv(predivAsync, 0);
-#else
-      RTC_setPrediv(predivAsync, predivSync);
-#endif
-      if (isAlarmASet) {
-        RTC_GetAlarm(ALARM_A, &alarmDay, &alarmHours, &alarmMinutes, &alarmSeconds, &alarmSubseconds, &alarmPeriod, &alarmMask);
-      }
-#ifdef RTC_ALARM_B
-      if (isAlarmBSet) {
-        RTC_GetAlarm(ALARM_B, &alarmBDay, &alarmBHours, &alarmBMinutes, &alarmBSeconds, &alarmBSubseconds, &alarmBPeriod, &alarmBMask);
-      }
-#endif
-      RTC_DeInit(false);
+      // RTC is already initialized, but RTC clock source is changed:
+      // the Backup Domain is reset, the calendar, alarms, backup registers
+      // and calibration are saved before and restored after
+      RTC_SwitchClock(source);
+    } else {
+      // RTC is already initialized, and RTC stays on the same clock source
       // Init RTC clock
       RTC_initClock(source);
+#if !defined(STM32F1xx)
+      rtcInitialized = true;
+      if (predivPending) {
+        // Write the prescalers set before the init, keeping the time
+        uint32_t asynch = predivAsync, synch = predivSync;
+        predivAsync = LL_RTC_GetAsynchPrescaler(RtcHandle.Instance);
+        predivSync = LL_RTC_GetSynchPrescaler(RtcHandle.Instance);
+        RTC_setConversionFactors(predivAsync, predivSync);
+        RTC_WritePrediv(asynch, synch);
+        predivPending = false;
+      }
+#endif /* !STM32F1xx */
+      // This initialize variables: predivAsync, predivSync and predivSync_bits
 #if defined(STM32F1xx)
       RTC_getPrediv(&(RtcHandle.Init.AsynchPrediv), NULL);
 #else
       RTC_getPrediv(&(RtcHandle.Init.AsynchPrediv), &(RtcHandle.Init.SynchPrediv));
 #endif
-#if defined(RTC_BINARY_NONE)
-      /*
-       * If RTC BIN mode changed, calling the HAL_RTC_Init will
-       * force the update of the BIN register in the RTC_ICSR
-       */
-      RTC_BinaryConf(mode);
-#endif /* RTC_BINARY_NONE */
-      HAL_RTC_Init(&RtcHandle);
-      // Restore config
-      RTC_SetTime(hours, minutes, seconds, subSeconds, period);
-      RTC_SetDate(years, month, days, weekDay);
-      if (isAlarmASet) {
-        RTC_StartAlarm(ALARM_A, alarmDay, alarmHours, alarmMinutes, alarmSeconds, alarmSubseconds, alarmPeriod, alarmMask);
-      }
-#ifdef RTC_ALARM_B
-      if (isAlarmBSet) {
-        RTC_StartAlarm(ALARM_B, alarmBDay, alarmBHours, alarmBMinutes, alarmBSeconds, alarmBSubseconds, alarmBPeriod, alarmBMask);
-      }
-#endif
-    } else {
-      // RTC is already initialized, and RTC stays on the same clock source
-      // Init RTC clock
-      RTC_initClock(source);
-      // This initialize variables: predivAsync, predivSync and predivSync_bits
-#if defined(STM32F1xx)
-      RTC_getPrediv(&(RtcHandle.Init.AsynchPrediv), NULL);
-#else
-      RTC_getPrediv(&(RtcHandle.Init.AsynchPrediv), &(RtcHandle.Init.SynchPrediv));
-#endif
+#if defined(RTC_LSI_TRIM_SUPPORT)
+      if (lsiTrim) {
+        RTC_LoadPrediv();
+      }
+#endif /* RTC_LSI_TRIM_SUPPORT */
 #if defined(RTC_BINARY_NONE)
       RTC_BinaryConf(mode);
       /*
@@ -662,6 +1151,12 @@ bool RTC_init(hourFormat_t format, binaryMode_t mode, sourceClock_t source, bool
   /* Enable Direct Read of the calendar registers (not through Shadow) */
   HAL_RTCEx_EnableBypassShadow(&RtcHandle);
 #endif
+#if defined(RTC_BKP_FINGERPRINT)
+  RTC_SaveFingerprint();
+#endif /* RTC_BKP_FINGERPRINT */
+#if defined(RTC_LSECSS_SUPPORT)
+  RTC_StartLseCss();
+#endif /* RTC_LSECSS_SUPPORT */
 
   /*
    * NOTE: freezing the RTC during stop mode (lowPower deepSleep)
@@ -671,6 +1166,117 @@ bool RTC_init(hourFormat_t format, binaryMode_t mode, sourceClock_t source, bool
   return reinit;
 }
 
+/**
+  * @brief Switch the RTC clock source: the backup domain is reset, then the
+  *        calendar, the alarms, the backup registers, the calibration and the
+  *        One-Second and SubSeconds underflow interrupts are restored.
+  * @param source: new RTC clock source, with its frequency and prescalers set
+  * @retval None
+  */
+static void RTC_SwitchClock(sourceClock_t source)
+{
+  dateTime_t dateTime;
+  hourAM_PM_t alarmPeriod = HOUR_AM;
+  uint32_t alarmSubseconds = 0;
+  uint8_t alarmMask = 0, alarmDay = 0, alarmHours = 0, alarmMinutes = 0, alarmSeconds = 0;
+  bool isAlarmASet = RTC_IsAlarmSet(ALARM_A);
+#ifdef RTC_ALARM_B
+  hourAM_PM_t alarmBPeriod = HOUR_AM;
+  uint8_t alarmBMask = 0, alarmBDay = 0, alarmBHours = 0, alarmBMinutes = 0, alarmBSeconds = 0;
+  uint32_t alarmBSubseconds = 0;
+  bool isAlarmBSet = RTC_IsAlarmSet(ALARM_B);
+#endif
+  uint32_t backup[RTC_BKP_SAVE_NB];
+
+  RTC_GetDateTime(&dateTime);
+  if (isAlarmASet) {
+    RTC_GetAlarm(ALARM_A, &alarmDay, &alarmHours, &alarmMinutes, &alarmSeconds, &alarmSubseconds, &alarmPeriod, &alarmMask);
+  }
+#ifdef RTC_ALARM_B
+  if (isAlarmBSet) {
+    RTC_GetAlarm(ALARM_B, &alarmBDay, &alarmBHours, &alarmBMinutes, &alarmBSeconds, &alarmBSubseconds, &alarmBPeriod, &alarmBMask);
+  }
+#endif
+  for (uint32_t i = 0; i < RTC_BKP_SAVE_NB; i++) {
+    backup[i] = getBackupRegister(RTC_BKP_FIRST + i);
+  }
+#ifdef ONESECOND_IRQn
+  bool secondsIrq = (RTCSecondsIrqCallback != NULL) || isSecondsCountEnabled;
+#endif /* ONESECOND_IRQn */
+#ifdef STM32WLxx
+  bool subSecondsUnderflowIrq = isSubSecondsUnderflowIrqSet;
+#endif /* STM32WLxx */
+#if defined(RTC_CALIB_SUPPORT)
+  /* Without the slew in progress */
+  int32_t calibration = RTC_GetCalibration();
+#endif /* RTC_CALIB_SUPPORT */
+#if defined(RTC_SLEW_SUPPORT)
+  slewSeconds = 0;
+  slewSecondsIrq = false;
+#endif /* RTC_SLEW_SUPPORT */
+
+  // As clock source changed, force update prediv with user or computed ones
+  // (after the reads above, converted with the current ones)
+  if (!clkConfigured || (source != clkSrc)) {
+    RTC_SetClockSource(source);
+  }
+#if defined(STM32F1xx)
+  RTC_setPrediv(predivAsync, 0);
+#else
+  if (predivComputed) {
+    RTC_setPrediv(PREDIVA_MAX + 1, PREDIVS_MAX + 1);
+  } else {
+    RTC_setPrediv(predivAsync, predivSync);
+  }
+#endif
+
+  /* The RTC clock selection can only be changed by a backup domain reset */
+  resetBackupDomain();
+#ifdef __HAL_RCC_RTC_ENABLE
+  __HAL_RCC_RTC_ENABLE();
+#endif
+  RTC_initHardware(initMode, source);
+#if defined(RTC_CR_BYPSHAD)
+  HAL_RTCEx_EnableBypassShadow(&RtcHandle);
+#endif
+
+  for (uint32_t i = 0; i < RTC_BKP_SAVE_NB; i++) {
+    setBackupRegister(RTC_BKP_FIRST + i, backup[i]);
+  }
+#if defined(RTC_CALIB_SUPPORT)
+  if (calibration != 0) {
+    RTC_SetCalibration(calibration);
+  }
+#endif /* RTC_CALIB_SUPPORT */
+#if defined(RTC_BKP_FINGERPRINT)
+  RTC_SaveFingerprint();
+#endif /* RTC_BKP_FINGERPRINT */
+  /* Setting the date and time restarts the second, then its phase is restored */
+  (void)RTC_SetDateTime(&dateTime);
+  if (isAlarmASet) {
+    RTC_StartAlarm(ALARM_A, alarmDay, alarmHours, alarmMinutes, alarmSeconds, alarmSubseconds, alarmPeriod, alarmMask);
+  }
+#ifdef RTC_ALARM_B
+  if (isAlarmBSet) {
+    RTC_StartAlarm(ALARM_B, alarmBDay, alarmBHours, alarmBMinutes, alarmBSeconds, alarmBSubseconds, alarmBPeriod, alarmBMask);
+  }
+#endif
+#ifdef ONESECOND_IRQn
+  if (secondsIrq) {
+    RTC_EnableSecondsIrq();
+  }
+#endif /* ONESECOND_IRQn */
+#ifdef STM32WLxx
+  if (subSecondsUnderflowIrq) {
+    isSubSecondsUnderflowIrqSet = false;
+    attachSubSecondsUnderflowIrqCallback(RTCSubSecondsUnderflowIrqCallback);
+  }
+#endif /* STM32WLxx */
+#if defined(RTC_LSECSS_SUPPORT)
+  RTC_StartLseCss();
+#endif /* RTC_LSECSS_SUPPORT */
+}
+
 /**
   * @brief RTC deinitialization. Stop the RTC.
   * @param reset_cb: reset user callback
@@ -679,6 +1285,13 @@ bool RTC_init(hourFormat_t format, binaryMode_t mode, sourceClock_t source, bool
 void RTC_DeInit(bool reset_cb)
 {
   HAL_RTC_DeInit(&RtcHandle);
+#if !defined(STM32F1xx)
+  rtcInitialized = false;
+#endif /* !STM32F1xx */
+#if defined(RTC_BKP_FINGERPRINT)
+  /* The configuration is no more the one saved */
+  setBackupRegister(RTC_BKP_FINGERPRINT, 0);
+#endif /* RTC_BKP_FINGERPRINT */
   /* Peripheral clock disable */
 #ifdef __HAL_RCC_RTC_DISABLE
   __HAL_RCC_RTC_DISABLE();
@@ -689,9 +1302,15 @@ void RTC_DeInit(bool reset_cb)
   HAL_NVIC_DisableIRQ(RTC_Alarm_IRQn);
 #ifdef ONESECOND_IRQn
   HAL_NVIC_DisableIRQ(ONESECOND_IRQn);
+  isSecondsCountEnabled = false;
 #endif
+#if defined(RTC_SLEW_SUPPORT)
+  slewSeconds = 0;
+  slewSecondsIrq = false;
+#endif /* RTC_SLEW_SUPPORT */
 #ifdef STM32WLxx
   HAL_NVIC_DisableIRQ(TAMP_STAMP_LSECSS_SSRU_IRQn);
+  isSubSecondsUnderflowIrqSet = false;
 #endif
   if (reset_cb) {
     RTCUserCallback = NULL;
@@ -725,6 +1344,18 @@ bool RTC_IsConfigured(void)
 #endif
 }
 
+/**
+  * @brief Note a write of the calendar: a reference read before is no more
+  *        valid
+  * @retval None
+  */
+static inline void RTC_CalendarWritten(void)
+{
+#if defined(RTC_LSECSS_SUPPORT)
+  lseRefValid = false;
+#endif /* RTC_LSECSS_SUPPORT */
+}
+
 /**
   * @brief Set RTC time
   * @param hours: 0-12 or 0-23. Depends on the format used.
@@ -732,12 +1363,12 @@ bool RTC_IsConfigured(void)
   * @param seconds: 0-59
   * @param subSeconds: 0-999 (not used)
   * @param period: select HOUR_AM or HOUR_PM period in case RTC is set in 12 hours mode. Else ignored.
-  * @retval None
+  * @retval True if set with its subsecond phase, else false
   */
-void RTC_SetTime(uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSeconds, hourAM_PM_t period)
+bool RTC_SetTime(uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSeconds, hourAM_PM_t period)
 {
   RTC_TimeTypeDef RTC_TimeStruct;
-  UNUSED(subSeconds); /* not used (read-only register) */
+  bool status = false;
   /* Ignore time AM PM configuration if in 24 hours format */
   if (initFormat == HOUR_FORMAT_24) {
     period = HOUR_AM;
@@ -754,20 +1385,82 @@ void RTC_SetTime(uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSe
     } else {
       RTC_TimeStruct.TimeFormat = RTC_HOURFORMAT12_AM;
     }
-#if defined(RTC_SSR_SS)
-    /* subSeconds is read only, so no need to set it */
-    /*RTC_TimeStruct.SubSeconds = subSeconds;*/
-    /*RTC_TimeStruct.SecondFraction = 0;*/
-#endif /* RTC_SSR_SS */
     RTC_TimeStruct.DayLightSaving = RTC_DAYLIGHTSAVING_NONE;
     RTC_TimeStruct.StoreOperation = RTC_STOREOPERATION_RESET;
 #else
     UNUSED(period);
 #endif /* !STM32F1xx */
 
-    HAL_RTC_SetTime(&RtcHandle, &RTC_TimeStruct, RTC_FORMAT_BIN);
+    /*
+     * The SubSecond register is read only and the second restarts when
+     * the time is set: the subsecond phase is then set with a shift.
+     */
+    RTC_CalendarWritten();
+    status = (HAL_RTC_SetTime(&RtcHandle, &RTC_TimeStruct, RTC_FORMAT_BIN) == HAL_OK)
+             && RTC_SetPhase(subSeconds);
+  }
+  return status;
+}
+
+/**
+  * @brief Align the subsecond phase of a second which has just been set
+  * @param subSeconds: 0-999 milliseconds, else ignored
+  * @retval False if the shift failed, else true
+  */
+static bool RTC_SetPhase(uint32_t subSeconds)
+{
+#if defined(RTC_SHIFTR_SUBFS)
+  if ((subSeconds != 0) && (subSeconds < 1000)) {
+    return RTC_ShiftSubSeconds((int32_t)RTC_MsToTicks(subSeconds, predivSync + 1));
+  }
+#else
+  UNUSED(subSeconds);
+#endif /* RTC_SHIFTR_SUBFS */
+  return true;
+}
+
+#if defined(RTC_SHIFTR_SUBFS)
+/**
+  * @brief Shift the subsecond phase of the running calendar, without
+  *        entering the initialization mode (BCD mode only)
+  * @param ticks: nb of SubSecond ticks to advance (> 0) or delay (< 0)
+  *        the calendar, lower than one second
+  * @retval True if the shift is done else false (an advance is refused
+  *         while a previous delay leaves the calendar one second ahead,
+  *         until the next second)
+  */
+bool RTC_ShiftSubSeconds(int32_t ticks)
+{
+  bool status = false;
+  uint32_t ticksPerSecond = predivSync + 1;
+  uint32_t nbTicks = (ticks < 0) ? (uint32_t)(-ticks) : (uint32_t)ticks;
+
+  if ((initMode == MODE_BINARY_NONE) && (nbTicks != 0) && (nbTicks < ticksPerSecond)
+      && ((ticks < 0) || !RTC_IsSecondAhead(READ_REG(RtcHandle.Instance->SSR)))) {
+    RTC_CalendarWritten();
+    status = (HAL_RTCEx_SetSynchroShift(&RtcHandle, (ticks > 0) ? RTC_SHIFTADD1S_SET : RTC_SHIFTADD1S_RESET,
+                                        RTC_ShiftSubFs(ticks, ticksPerSecond)) == HAL_OK);
+  }
+  return status;
+}
+
+/**
+  * @brief Set the subseconds of the running calendar with a shift,
+  *        without changing the time (BCD mode only)
+  * @param subSeconds: 0-999 milliseconds
+  * @retval True if done else false
+  */
+bool RTC_SetSubSeconds(uint32_t subSeconds)
+{
+  bool status = false;
+  if ((initMode == MODE_BINARY_NONE) && (subSeconds < 1000)) {
+    int32_t target = (int32_t)RTC_MsToTicks(subSeconds, predivSync + 1);
+    int32_t current = (int32_t)RTC_SubSecondsToTicks(READ_REG(RtcHandle.Instance->SSR));
+    status = (target == current) || RTC_ShiftSubSeconds(target - current);
   }
+  return status;
 }
+#endif /* RTC_SHIFTR_SUBFS */
 
 /**
   * @brief Get RTC time
@@ -780,6 +1473,77 @@ void RTC_SetTime(uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSe
   */
 void RTC_GetTime(uint8_t *hours, uint8_t *minutes, uint8_t *seconds, uint32_t *subSeconds, hourAM_PM_t *period)
 {
+#if defined(RTC_SSR_SS)
+  uint32_t ssr = 0;
+
+  if (RTC_ReadTime(hours, minutes, seconds, &ssr, period)) {
+#if defined(RTC_SHIFTR_SUBFS)
+    if (RTC_IsSecondAhead(ssr)) {
+      /* Any day after the first one, only the time is kept */
+      dateTime_t dateTime = {0, 1, 2, 7, *hours, *minutes, *seconds, HOUR_AM, 0, 0};
+      if (period != NULL) {
+        dateTime.period = *period;
+      }
+      RTC_SecondBack(&dateTime);
+      *hours = dateTime.hours;
+      *minutes = dateTime.minutes;
+      *seconds = dateTime.seconds;
+      if (period != NULL) {
+        *period = dateTime.period;
+      }
+    }
+#endif /* RTC_SHIFTR_SUBFS */
+    if (subSeconds != NULL) {
+      *subSeconds = RTC_SubSecondsToMs(ssr);
+    }
+  }
+#else
+  UNUSED(subSeconds);
+  (void)RTC_ReadTime(hours, minutes, seconds, NULL, period);
+#endif /* RTC_SSR_SS */
+}
+
+/**
+  * @brief Read the RTC time, with the raw SubSecond register value
+  * @param hours: 0-12 or 0-23. Depends on the format used.
+  * @param minutes: 0-59
+  * @param seconds: 0-59
+  * @param ssr: SubSecond register value (optional could be NULL)
+  * @param period: HOUR_AM or HOUR_PM period in case RTC is set in 12 hours mode (optional could be NULL).
+  * @retval True if read, false if a mandatory parameter is NULL
+  */
+static bool RTC_ReadTime(uint8_t *hours, uint8_t *minutes, uint8_t *seconds, uint32_t *ssr, hourAM_PM_t *period)
+{
+#if defined(RTC_FAST_READ)
+  if ((hours != NULL) && (minutes != NULL) && (seconds != NULL)) {
+    calendarReadCount++;
+#if defined(RTC_SSR_SS)
+    /* Reading SSR then TR locks the shadow registers until DR is read */
+    uint32_t ssrValue = READ_REG(RtcHandle.Instance->SSR);
+#endif /* RTC_SSR_SS */
+    uint32_t tr = READ_REG(RtcHandle.Instance->TR);
+#if defined(RTC_BINARY_NONE)
+    if (initMode == MODE_BINARY_ONLY) {
+      /* in BIN mode, only the subsecond is used */
+      tr = 0;
+    }
+#endif /* RTC_BINARY_NONE */
+    uint32_t time = RTC_Bcd2Bin(tr & RTC_TR_BCD_MASK);
+    *hours = (uint8_t)(time >> RTC_TR_HU_Pos);
+    *minutes = (uint8_t)(time >> RTC_TR_MNU_Pos);
+    *seconds = (uint8_t)(time >> RTC_TR_SU_Pos);
+    if (period != NULL) {
+      *period = (tr & RTC_TR_PM) ? HOUR_PM : HOUR_AM;
+    }
+#if defined(RTC_SSR_SS)
+    if (ssr != NULL) {
+      *ssr = ssrValue;
+    }
+#else
+    UNUSED(ssr);
+#endif /* RTC_SSR_SS */
+  }
+#else
   RTC_TimeTypeDef RTC_TimeStruct = {0}; /* in BIN mode, only the subsecond is used */
 
   if ((hours != NULL) && (minutes != NULL) && (seconds != NULL)) {
@@ -789,6 +1553,7 @@ void RTC_GetTime(uint8_t *hours, uint8_t *minutes, uint8_t *seconds, uint32_t *s
     uint8_t current_date = RtcHandle.DateToUpdate.Date;
 #endif
 
+    calendarReadCount++;
     HAL_RTC_GetTime(&RtcHandle, &RTC_TimeStruct, RTC_FORMAT_BIN);
     *hours = RTC_TimeStruct.Hours;
     *minutes = RTC_TimeStruct.Minutes;
@@ -802,34 +1567,81 @@ void RTC_GetTime(uint8_t *hours, uint8_t *minutes, uint8_t *seconds, uint32_t *s
       }
     }
 #if defined(RTC_SSR_SS)
-    if (subSeconds != NULL) {
-      /*
-       * The subsecond is the free-running downcounter, to be converted in milliseconds.
-       */
-      if (initMode == MODE_BINARY_ONLY) {
-        *subSeconds = (((UINT32_MAX - RTC_TimeStruct.SubSeconds + 1) & UINT32_MAX)
-                       * 1000) / fqce_apre;
-      } else if (initMode == MODE_BINARY_MIX) {
-        *subSeconds = (((UINT32_MAX - RTC_TimeStruct.SubSeconds) & predivSync)
-                       * 1000) / fqce_apre;
-      } else {
-        /* the subsecond register value is converted in millisec on 32bit */
-        *subSeconds = ((predivSync - RTC_TimeStruct.SubSeconds) * 1000) / (predivSync + 1);
-      }
+    if (ssr != NULL) {
+      *ssr = RTC_TimeStruct.SubSeconds;
     }
 #else
-    UNUSED(subSeconds);
+    UNUSED(ssr);
 #endif /* RTC_SSR_SS */
 #else
     UNUSED(period);
-    UNUSED(subSeconds);
+    UNUSED(ssr);
 
     if (current_date != RtcHandle.DateToUpdate.Date) {
       RTC_StoreDate();
     }
 #endif /* !STM32F1xx */
   }
+#endif /* RTC_FAST_READ */
+  return (hours != NULL) && (minutes != NULL) && (seconds != NULL);
+}
+
+#if defined(RTC_SSR_SS)
+/**
+  * @brief Convert the SubSecond register value in milliseconds
+  * @param subSeconds: RTC SubSecond register value
+  * @retval 0-999 milliseconds or 32bit nb of milliseconds in BIN mode
+  */
+static uint32_t RTC_SubSecondsToMs(uint32_t subSeconds)
+{
+  uint32_t ms;
+  /*
+   * The subsecond is the free-running downcounter, to be converted in milliseconds.
+   */
+  if (initMode == MODE_BINARY_ONLY) {
+    ms = RTC_divRecip(((UINT32_MAX - subSeconds + 1) & UINT32_MAX) * 1000, fqce_apre, fqce_apre_recip);
+  } else if (initMode == MODE_BINARY_MIX) {
+    ms = RTC_divRecip(((UINT32_MAX - subSeconds) & predivSync) * 1000, fqce_apre, fqce_apre_recip);
+  } else {
+    /* the subsecond register value is converted in millisec on 32bit */
+    ms = RTC_divRecip(RTC_SsrToTicks(predivSync, subSeconds) * 1000, predivSync + 1, predivSync_recip);
+  }
+  return ms;
+}
+
+/**
+  * @brief Convert the SubSecond register value in elapsed ticks
+  * @param subSeconds: RTC SubSecond register value
+  * @retval nb of ticks elapsed in the second or 32bit nb of ticks in BIN mode
+  */
+static uint32_t RTC_SubSecondsToTicks(uint32_t subSeconds)
+{
+  uint32_t ticks;
+  if (initMode == MODE_BINARY_ONLY) {
+    ticks = UINT32_MAX - subSeconds;
+  } else if (initMode == MODE_BINARY_MIX) {
+    ticks = (UINT32_MAX - subSeconds) & predivSync;
+  } else {
+    ticks = RTC_SsrToTicks(predivSync, subSeconds);
+  }
+  return ticks;
+}
+#endif /* RTC_SSR_SS */
+
+#if defined(RTC_CR_BYPSHAD) && defined(RTC_SSR_SS)
+/**
+  * @brief Check if the calendar second changed between two SubSecond register reads
+  * @param ssrStart: SubSecond register value read before the calendar registers
+  * @param ssrEnd: SubSecond register value read after the calendar registers
+  * @retval True if a new second started in between
+  */
+static inline bool RTC_IsSecondRollover(uint32_t ssrStart, uint32_t ssrEnd)
+{
+  /* In BIN only mode, the calendar is not used */
+  return (initMode != MODE_BINARY_ONLY)
+         && RTC_SecondRollover(initMode == MODE_BINARY_MIX, predivSync, ssrStart, ssrEnd);
 }
+#endif /* RTC_CR_BYPSHAD && RTC_SSR_SS */
 
 /**
   * @brief Set RTC calendar
@@ -837,23 +1649,119 @@ void RTC_GetTime(uint8_t *hours, uint8_t *minutes, uint8_t *seconds, uint32_t *s
   * @param month: 1-12
   * @param day: 1-31
   * @param wday: 1-7
-  * @retval None
+  * @retval True if set else false
   */
-void RTC_SetDate(uint8_t year, uint8_t month, uint8_t day, uint8_t wday)
+bool RTC_SetDate(uint8_t year, uint8_t month, uint8_t day, uint8_t wday)
 {
   RTC_DateTypeDef RTC_DateStruct;
+  bool status = false;
 
   if (IS_RTC_YEAR(year) && IS_RTC_MONTH(month) && IS_RTC_DATE(day) && IS_RTC_WEEKDAY(wday)) {
     RTC_DateStruct.Year = year;
     RTC_DateStruct.Month = month;
     RTC_DateStruct.Date = day;
     RTC_DateStruct.WeekDay = wday;
-    HAL_RTC_SetDate(&RtcHandle, &RTC_DateStruct, RTC_FORMAT_BIN);
+    RTC_CalendarWritten();
+    status = (HAL_RTC_SetDate(&RtcHandle, &RTC_DateStruct, RTC_FORMAT_BIN) == HAL_OK);
 #if defined(STM32F1xx)
     RTC_StoreDate();
 #endif /* STM32F1xx */
   }
+  return status;
+}
+
+/**
+  * @brief Set RTC date and time at once
+  * @note  Time and date registers are written in a single initialization
+  *        mode session (for stm32F1xx, date and time are set one after the other).
+  *        The subsecond phase is then set with a shift if supported.
+  * @param dateTime: pointer to the date and time to set (subseconds: 0-999 ms,
+  *        0 to restart the second when the time is set)
+  * @retval True if set, false if invalid or if the initialization mode
+  *         could not be entered (the calendar is not changed), or if the
+  *         subsecond phase could not be set
+  */
+bool RTC_SetDateTime(const dateTime_t *dateTime)
+{
+  bool status = false;
+
+  if (dateTime == NULL) {
+    return false;
+  }
+#if defined(STM32F1xx)
+  status = RTC_SetDate(dateTime->year, dateTime->month, dateTime->day, dateTime->wday)
+           && RTC_SetTime(dateTime->hours, dateTime->minutes, dateTime->seconds, dateTime->subSeconds, dateTime->period);
+#else
+  hourAM_PM_t period = dateTime->period;
+  /* Ignore time AM PM configuration if in 24 hours format */
+  if (initFormat == HOUR_FORMAT_24) {
+    period = HOUR_AM;
+  }
+
+  if ((((initFormat == HOUR_FORMAT_24) && IS_RTC_HOUR24(dateTime->hours)) || IS_RTC_HOUR12(dateTime->hours))
+      && IS_RTC_MINUTES(dateTime->minutes) && IS_RTC_SECONDS(dateTime->seconds)
+      && IS_RTC_YEAR(dateTime->year) && IS_RTC_MONTH(dateTime->month)
+      && IS_RTC_DATE(dateTime->day) && IS_RTC_WEEKDAY(dateTime->wday)) {
+    uint32_t tr = RTC_PackTime(dateTime->hours, dateTime->minutes, dateTime->seconds, period == HOUR_PM);
+    uint32_t dr = RTC_PackDate(dateTime->year, dateTime->month, dateTime->day, dateTime->wday);
+
+    RTC_CalendarWritten();
+    __HAL_RTC_WRITEPROTECTION_DISABLE(&RtcHandle);
+    if (RTC_InitModeEnter()) {
+      WRITE_REG(RtcHandle.Instance->TR, tr);
+      WRITE_REG(RtcHandle.Instance->DR, dr);
+#if defined(RTC_CR_BKP)
+      /* No daylight saving, store operation reset (as RTC_SetTime()) */
+      CLEAR_BIT(RtcHandle.Instance->CR, RTC_CR_BKP);
+#endif /* RTC_CR_BKP */
+      RTC_InitModeExit();
+      status = true;
+    }
+    __HAL_RTC_WRITEPROTECTION_ENABLE(&RtcHandle);
+    if (status) {
+      status = RTC_SetPhase(dateTime->subSeconds);
+    }
+  }
+#endif /* STM32F1xx */
+  return status;
+}
+
+#if !defined(STM32F1xx)
+/**
+  * @brief Enter the RTC initialization mode
+  * @note  Write protection must be disabled.
+  * @retval True if the calendar can be written, false on timeout
+  */
+static bool RTC_InitModeEnter(void)
+{
+  uint32_t tickstart = HAL_GetTick();
+
+  LL_RTC_EnableInitMode(RtcHandle.Instance);
+  while (!LL_RTC_IsActiveFlag_INIT(RtcHandle.Instance)) {
+    if ((HAL_GetTick() - tickstart) > RTC_TIMEOUT_VALUE) {
+      LL_RTC_DisableInitMode(RtcHandle.Instance);
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+  * @brief Exit the RTC initialization mode
+  * @note  Wait for the shadow registers update if not bypassed.
+  * @retval None
+  */
+static void RTC_InitModeExit(void)
+{
+  LL_RTC_DisableInitMode(RtcHandle.Instance);
+#if defined(RTC_CR_BYPSHAD)
+  if (READ_BIT(RtcHandle.Instance->CR, RTC_CR_BYPSHAD) == 0U)
+#endif /* RTC_CR_BYPSHAD */
+  {
+    HAL_RTC_WaitForSynchro(&RtcHandle);
+  }
 }
+#endif /* !STM32F1xx */
 
 /**
   * @brief Get RTC calendar
@@ -865,55 +1773,356 @@ void RTC_SetDate(uint8_t year, uint8_t month, uint8_t day, uint8_t wday)
   */
 void RTC_GetDate(uint8_t *year, uint8_t *month, uint8_t *day, uint8_t *wday)
 {
+#if defined(RTC_FAST_READ)
+  if ((year != NULL) && (month != NULL) && (day != NULL) && (wday != NULL)) {
+    calendarReadCount++;
+    uint32_t dr = READ_REG(RtcHandle.Instance->DR);
+#if defined(RTC_BINARY_NONE)
+    if (initMode == MODE_BINARY_ONLY) {
+      /* in BIN mode, the date is not used */
+      dr = 0;
+    }
+#endif /* RTC_BINARY_NONE */
+    uint32_t date = RTC_Bcd2Bin(dr & RTC_DR_BCD_MASK);
+    *year = (uint8_t)(date >> RTC_DR_YU_Pos);
+    *month = (uint8_t)(date >> RTC_DR_MU_Pos);
+    *day = (uint8_t)(date >> RTC_DR_DU_Pos);
+    *wday = (uint8_t)((dr & RTC_DR_WDU) >> RTC_DR_WDU_Pos);
+  }
+#else
   RTC_DateTypeDef RTC_DateStruct = {0}; /* in BIN mode, the date is not used */
 
   if ((year != NULL) && (month != NULL) && (day != NULL) && (wday != NULL)) {
+    calendarReadCount++;
     HAL_RTC_GetDate(&RtcHandle, &RTC_DateStruct, RTC_FORMAT_BIN);
     *year = RTC_DateStruct.Year;
     *month = RTC_DateStruct.Month;
     *day = RTC_DateStruct.Date;
     *wday = RTC_DateStruct.WeekDay;
   }
+#endif /* RTC_FAST_READ */
 }
 
 /**
-  * @brief Set RTC alarm and activate it with IT mode with 64bit accuracy on subsecond param
-  *        Mainly used by Lorawan in RTC BIN or MIX mode
-  * @param name: ALARM_A or ALARM_B if exists
-  * @param day: 1-31 (day of the month)
-  * @param hours: 0-12 or 0-23 depends on the hours mode.
-  * @param minutes: 0-59
-  * @param seconds: 0-59
-  * @param subSeconds: 0-999 milliseconds or 64bit nb of milliseconds in no BCD mode
-  * @param period: HOUR_AM or HOUR_PM if in 12 hours mode else ignored.
-  * @param mask: configure alarm behavior using alarmMask_t combination.
-  *              See AN4579 Table 5 for possible values.
+  * @brief Get a coherent RTC date and time snapshot
+  * @note  As the shadow registers are bypassed, the SubSecond register is read
+  *        before and after the time and date registers. If a new second started
+  *        in between, the read is done again (up to RTC_DATETIME_READ_MAX times).
+  *        While a shift delaying the calendar leaves it one second ahead,
+  *        the second is taken back.
+  * @param dateTime: pointer where to store the date and time
   * @retval None
   */
-void RTC_StartAlarm64(alarm_t name, uint8_t day, uint8_t hours, uint8_t minutes, uint8_t seconds, uint64_t subSeconds, hourAM_PM_t period, uint8_t mask)
+void RTC_GetDateTime(dateTime_t *dateTime)
 {
-#if !defined(RTC_SSR_SS)
-  UNUSED(subSeconds);
-#endif
-  RTC_AlarmTypeDef RTC_AlarmStructure;
+  if (dateTime != NULL) {
+#if defined(RTC_CR_BYPSHAD) && defined(RTC_SSR_SS)
+    uint32_t ssr, tr, dr, ssrEnd;
+    uint8_t nbRead = 0;
+
+    do {
+      ssr = READ_REG(RtcHandle.Instance->SSR);
+      tr = READ_REG(RtcHandle.Instance->TR);
+      dr = READ_REG(RtcHandle.Instance->DR);
+      ssrEnd = READ_REG(RtcHandle.Instance->SSR);
+      nbRead++;
+    } while (RTC_IsSecondRollover(ssr, ssrEnd) && (nbRead < RTC_DATETIME_READ_MAX));
+    calendarReadCount += nbRead;
+
+    uint32_t time = RTC_Bcd2Bin(tr & RTC_TR_BCD_MASK);
+    uint32_t date = RTC_Bcd2Bin(dr & RTC_DR_BCD_MASK);
+    dateTime->hours = (uint8_t)(time >> RTC_TR_HU_Pos);
+    dateTime->minutes = (uint8_t)(time >> RTC_TR_MNU_Pos);
+    dateTime->seconds = (uint8_t)(time >> RTC_TR_SU_Pos);
+    dateTime->period = (tr & RTC_TR_PM) ? HOUR_PM : HOUR_AM;
+    dateTime->subSeconds = RTC_SubSecondsToMs(ssrEnd);
+    dateTime->subSecondTicks = RTC_SubSecondsToTicks(ssrEnd);
+    dateTime->year = (uint8_t)(date >> RTC_DR_YU_Pos);
+    dateTime->month = (uint8_t)(date >> RTC_DR_MU_Pos);
+    dateTime->day = (uint8_t)(date >> RTC_DR_DU_Pos);
+    dateTime->wday = (uint8_t)((dr & RTC_DR_WDU) >> RTC_DR_WDU_Pos);
+#if defined(RTC_SHIFTR_SUBFS)
+    if (RTC_IsSecondAhead(ssrEnd)) {
+      RTC_SecondBack(dateTime);
+    }
+#endif /* RTC_SHIFTR_SUBFS */
+#else
+    /*
+     * Reading the time locks the date shadow register until it is read
+     * (for stm32F1xx, reading the time updates the date)
+     */
+    uint32_t ssr = 0;
 
-  /* Ignore time AM PM configuration if in 24 hours format */
-  if (initFormat == HOUR_FORMAT_24) {
-    period = HOUR_AM;
+    dateTime->period = HOUR_AM;
+    (void)RTC_ReadTime(&dateTime->hours, &dateTime->minutes, &dateTime->seconds,
+                       &ssr, &dateTime->period);
+    RTC_GetDate(&dateTime->year, &dateTime->month, &dateTime->day, &dateTime->wday);
+#if defined(RTC_SSR_SS)
+    /* SubSecond register value returned by the HAL */
+    dateTime->subSeconds = RTC_SubSecondsToMs(ssr);
+    dateTime->subSecondTicks = RTC_SubSecondsToTicks(ssr);
+#if defined(RTC_SHIFTR_SUBFS)
+    if (RTC_IsSecondAhead(ssr)) {
+      RTC_SecondBack(dateTime);
+    }
+#endif /* RTC_SHIFTR_SUBFS */
+#else
+    UNUSED(ssr);
+    dateTime->subSeconds = 0;
+    dateTime->subSecondTicks = 0;
+#endif /* RTC_SSR_SS */
+#endif /* RTC_CR_BYPSHAD && RTC_SSR_SS */
   }
+}
 
-  /* Use alarm A by default because it is common to all STM32 HAL */
-  RTC_AlarmStructure.Alarm = name;
+#if defined(RTC_SHIFTR_SUBFS) || defined(RTC_LSECSS_SUPPORT)
+/**
+  * @brief Get the number of milliseconds since 1st January 2000 of a
+  *        calendar date and time
+  * @param dateTime: date and time in the current hour format
+  * @retval nb of milliseconds
+  */
+static uint64_t RTC_Y2kMs(const dateTime_t *dateTime)
+{
+  uint8_t hours = dateTime->hours;
 
-  if ((((initFormat == HOUR_FORMAT_24) && IS_RTC_HOUR24(hours)) || IS_RTC_HOUR12(hours))
-      && IS_RTC_DATE(day) && IS_RTC_MINUTES(minutes) && IS_RTC_SECONDS(seconds)) {
-    /* Set RTC_AlarmStructure with calculated values*/
-    RTC_AlarmStructure.AlarmTime.Seconds = seconds;
-    RTC_AlarmStructure.AlarmTime.Minutes = minutes;
-    RTC_AlarmStructure.AlarmTime.Hours = hours;
+  if (initFormat == HOUR_FORMAT_12) {
+    hours = RTC_Hours24(hours, dateTime->period == HOUR_PM);
+  }
+  return ((uint64_t)RTC_Y2kSeconds(dateTime->year, dateTime->month, dateTime->day,
+                                   hours, dateTime->minutes, dateTime->seconds) * 1000U)
+         + dateTime->subSeconds;
+}
+
+/**
+  * @brief Set a calendar date and time from a number of milliseconds
+  *        since 1st January 2000
+  * @param dateTime: date and time to update, in the current hour format
+  *        (the SubSecond ticks are not changed)
+  * @param y2kMs: nb of milliseconds, up to 31st December 2099, 23:59:59.999
+  * @retval None
+  */
+static void RTC_Y2kMsToDateTime(dateTime_t *dateTime, uint64_t y2kMs)
+{
+  civilTime_t civil = RTC_CivilFromY2k((uint32_t)(y2kMs / 1000U));
+
+  dateTime->year = civil.year;
+  dateTime->month = civil.month;
+  dateTime->day = civil.day;
+  dateTime->wday = civil.wday;
+  dateTime->minutes = civil.minutes;
+  dateTime->seconds = civil.seconds;
+  dateTime->subSeconds = (uint32_t)(y2kMs % 1000U);
+  if (initFormat == HOUR_FORMAT_12) {
+    dateTime->hours = RTC_Hours12(civil.hours);
+    dateTime->period = (civil.hours >= 12U) ? HOUR_PM : HOUR_AM;
+  } else {
+    dateTime->hours = civil.hours;
+    dateTime->period = HOUR_AM;
+  }
+}
+#endif /* RTC_SHIFTR_SUBFS || RTC_LSECSS_SUPPORT */
+
+#if defined(RTC_SHIFTR_SUBFS)
+/**
+  * @brief Check if the calendar registers are one second ahead, after a
+  *        shift delaying the calendar (BCD mode only)
+  * @param ssr: SubSecond register value read with the calendar registers
+  * @retval True if one second must be taken back from the calendar registers
+  */
+static inline bool RTC_IsSecondAhead(uint32_t ssr)
+{
+  return (initMode == MODE_BINARY_NONE) && RTC_SecondAhead(predivSync, ssr);
+}
+
+/**
+  * @brief Take one second back from a date and time read while the
+  *        calendar registers are one second ahead
+  * @param dateTime: date and time to update, in the current hour format
+  * @retval None
+  */
+static void RTC_SecondBack(dateTime_t *dateTime)
+{
+  uint64_t y2kMs = RTC_Y2kMs(dateTime);
+
+  if (y2kMs >= 1000U) {
+    RTC_Y2kMsToDateTime(dateTime, y2kMs - 1000U);
+  }
+}
+#endif /* RTC_SHIFTR_SUBFS */
+
+/**
+  * @brief Get the nb of calendar register reads
+  * @note  Each time, date or date and time read is counted once
+  *        (date and time read again on a second rollover are counted too).
+  * @retval nb of reads since the start
+  */
+uint32_t RTC_GetReadCount(void)
+{
+  return calendarReadCount;
+}
+
+/**
+  * @brief Get the frequency of the RTC ticks
+  * @retval nb of ticks per second (1 if the SubSecond register is not supported)
+  */
+uint32_t RTC_GetTickFrequency(void)
+{
+#if defined(RTC_SSR_SS)
+  return fqce_apre;
+#else
+  return 1;
+#endif /* RTC_SSR_SS */
+}
+
+/**
+  * @brief Get the nb of SubSecond ticks in one calendar second
+  * @retval predivSync + 1, the tick frequency in BIN mode
+  *         (1 if the SubSecond register is not supported)
+  */
+uint32_t RTC_GetTicksPerSecond(void)
+{
+#if defined(RTC_SSR_SS)
+  return (initMode == MODE_BINARY_ONLY) ? fqce_apre : (predivSync + 1);
+#else
+  return 1;
+#endif /* RTC_SSR_SS */
+}
+
+#if defined(RTC_BINARY_NONE)
+/**
+  * @brief Update the SubSecond downcounter wrap count if not done by the
+  *        SubSeconds underflow interrupt
+  * @note  Must be called at least once per downcounter period
+  *        (about 36 hours at 32768Hz)
+  * @retval nb of ticks elapsed on the 32bit downcounter
+  */
+static uint32_t RTC_UpdateTicksWrap(void)
+{
+  uint32_t ticks = UINT32_MAX - READ_REG(RtcHandle.Instance->SSR);
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if (ticks < ticksLast) {
+    ticksWrapCount++;
+  }
+  ticksLast = ticks;
+  __set_PRIMASK(primask);
+  return ticks;
+}
+
+/**
+  * @brief Get the 64bit monotonic nb of ticks of the free-running SubSecond
+  *        downcounter (only in BIN or MIX mode)
+  * @note  The wrap count is maintained by the SubSeconds underflow interrupt
+  *        if attached (STM32WLxx), else it is checked at each call.
+  * @retval nb of ticks at RTC_GetTickFrequency() Hz
+  */
+uint64_t RTC_GetTicks(void)
+{
+  uint32_t high, low;
+#ifdef STM32WLxx
+  if (isSubSecondsUnderflowIrqSet) {
+    uint32_t wrapCount;
+    do {
+      wrapCount = ticksWrapCount;
+      low = UINT32_MAX - READ_REG(RtcHandle.Instance->SSR);
+      high = wrapCount;
+      /* Underflow not yet handled by the interrupt */
+      if (__HAL_RTC_SSRU_GET_FLAG(&RtcHandle, RTC_FLAG_SSRUF) && (low < (UINT32_MAX >> 1))) {
+        high++;
+      }
+    } while (ticksWrapCount != wrapCount);
+  } else
+#endif /* STM32WLxx */
+  {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    low = RTC_UpdateTicksWrap();
+    high = ticksWrapCount;
+    __set_PRIMASK(primask);
+  }
+  return ((uint64_t)high << 32) | low;
+}
+#endif /* RTC_BINARY_NONE */
+
+/**
+  * @brief Set RTC alarm and activate it with IT mode with 64bit accuracy on subsecond param
+  *        Mainly used by Lorawan in RTC BIN or MIX mode
+  * @param name: ALARM_A or ALARM_B if exists
+  * @param day: 1-31 (day of the month)
+  * @param hours: 0-12 or 0-23 depends on the hours mode.
+  * @param minutes: 0-59
+  * @param seconds: 0-59
+  * @param subSeconds: 0-999 milliseconds or 64bit nb of milliseconds in no BCD mode
+  * @param period: HOUR_AM or HOUR_PM if in 12 hours mode else ignored.
+  * @param mask: configure alarm behavior using alarmMask_t combination.
+  *              See AN4579 Table 5 for possible values.
+  * @retval None
+  */
+void RTC_StartAlarm64(alarm_t name, uint8_t day, uint8_t hours, uint8_t minutes, uint8_t seconds, uint64_t subSeconds, hourAM_PM_t period, uint8_t mask)
+{
+  RTC_StartAlarmInternal(name, day, hours, minutes, seconds, subSeconds, false, period, mask);
+}
+
+/**
+  * @brief Set RTC alarm and activate it with IT mode, the subsecond param being
+  *        a nb of ticks of the SubSecond register (no millisecond conversion)
+  * @param name: ALARM_A or ALARM_B if exists
+  * @param day: 1-31 (day of the month)
+  * @param hours: 0-12 or 0-23 depends on the hours mode.
+  * @param minutes: 0-59
+  * @param seconds: 0-59
+  * @param subSecondTicks: 0-predivSync ticks or 32bit nb of ticks in no BCD mode
+  * @param period: HOUR_AM or HOUR_PM if in 12 hours mode else ignored.
+  * @param mask: configure alarm behavior using alarmMask_t combination.
+  *              See AN4579 Table 5 for possible values.
+  * @retval None
+  */
+void RTC_StartAlarmTicks(alarm_t name, uint8_t day, uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSecondTicks, hourAM_PM_t period, uint8_t mask)
+{
+  RTC_StartAlarmInternal(name, day, hours, minutes, seconds, (uint64_t)subSecondTicks, true, period, mask);
+}
+
+/**
+  * @brief Set RTC alarm and activate it with IT mode
+  * @param name: ALARM_A or ALARM_B if exists
+  * @param day: 1-31 (day of the month)
+  * @param hours: 0-12 or 0-23 depends on the hours mode.
+  * @param minutes: 0-59
+  * @param seconds: 0-59
+  * @param subSeconds: nb of milliseconds or nb of ticks
+  * @param subSecondsInTicks: true if subSeconds is a nb of ticks
+  * @param period: HOUR_AM or HOUR_PM if in 12 hours mode else ignored.
+  * @param mask: configure alarm behavior using alarmMask_t combination.
+  * @retval None
+  */
+static void RTC_StartAlarmInternal(alarm_t name, uint8_t day, uint8_t hours, uint8_t minutes, uint8_t seconds,
+                                   uint64_t subSeconds, bool subSecondsInTicks, hourAM_PM_t period, uint8_t mask)
+{
+#if !defined(RTC_SSR_SS)
+  UNUSED(subSeconds);
+  UNUSED(subSecondsInTicks);
+#endif
+  RTC_AlarmTypeDef RTC_AlarmStructure;
+
+  /* Ignore time AM PM configuration if in 24 hours format */
+  if (initFormat == HOUR_FORMAT_24) {
+    period = HOUR_AM;
+  }
+
+  /* Use alarm A by default because it is common to all STM32 HAL */
+  RTC_AlarmStructure.Alarm = name;
+
+  if ((((initFormat == HOUR_FORMAT_24) && IS_RTC_HOUR24(hours)) || IS_RTC_HOUR12(hours))
+      && IS_RTC_DATE(day) && IS_RTC_MINUTES(minutes) && IS_RTC_SECONDS(seconds)) {
+    /* Set RTC_AlarmStructure with calculated values*/
+    RTC_AlarmStructure.AlarmTime.Seconds = seconds;
+    RTC_AlarmStructure.AlarmTime.Minutes = minutes;
+    RTC_AlarmStructure.AlarmTime.Hours = hours;
 #if !defined(STM32F1xx)
 #if defined(RTC_SSR_SS)
-    if (subSeconds < 1000) {
+    if ((subSecondsInTicks) ? (subSeconds <= predivSync) : (subSeconds < 1000)) {
 #ifdef RTC_ALARM_B
       if (name == ALARM_B) {
         RTC_AlarmStructure.AlarmSubSecondMask = predivSync_bits << RTC_ALRMBSSR_MASKSS_Pos;
@@ -928,10 +2137,11 @@ void RTC_StartAlarm64(alarm_t name, uint8_t day, uint8_t hours, uint8_t minutes,
        */
       if ((initMode == MODE_BINARY_ONLY) || (initMode == MODE_BINARY_MIX)) {
         /* the subsecond is the millisecond to be converted in a subsecond downcounter value */
-        uint64_t tmp = (subSeconds * (uint64_t)(predivSync + 1)) / (uint64_t)1000;
+        uint64_t tmp = (subSecondsInTicks) ? subSeconds : RTC_MsToTicks(subSeconds, predivSync + 1);
         RTC_AlarmStructure.AlarmTime.SubSeconds = (uint32_t)UINT32_MAX - (uint32_t)tmp;
       } else {
-        RTC_AlarmStructure.AlarmTime.SubSeconds = predivSync - ((uint32_t)subSeconds * (predivSync + 1)) / 1000;
+        uint64_t tmp = (subSecondsInTicks) ? subSeconds : RTC_MsToTicks(subSeconds, predivSync + 1);
+        RTC_AlarmStructure.AlarmTime.SubSeconds = predivSync - (uint32_t)tmp;
       }
     } else {
       RTC_AlarmStructure.AlarmSubSecondMask = RTC_ALARMSUBSECONDMASK_ALL;
@@ -999,12 +2209,13 @@ void RTC_StartAlarm64(alarm_t name, uint8_t day, uint8_t hours, uint8_t minutes,
        * For the conversion, we keep the accuracy on 64 bits, since otherwise we might
        * have an overflow even though the conversion result still fits in 32 bits.
        */
-      uint64_t tmp = (subSeconds * (uint64_t)(predivSync + 1)) / (uint64_t)1000;
+      uint64_t tmp = (subSecondsInTicks) ? subSeconds : RTC_MsToTicks(subSeconds, predivSync + 1);
       RTC_AlarmStructure.AlarmTime.SubSeconds = (uint32_t)UINT32_MAX - (uint32_t)tmp;
     } else
 #endif /* RTC_ICSR_BIN */
     {
-      RTC_AlarmStructure.AlarmTime.SubSeconds = predivSync - subSeconds * (predivSync + 1) / 1000;
+      uint64_t tmp = (subSecondsInTicks) ? subSeconds : RTC_MsToTicks(subSeconds, predivSync + 1);
+      RTC_AlarmStructure.AlarmTime.SubSeconds = predivSync - (uint32_t)tmp;
     }
     /* Set RTC_Alarm */
     HAL_RTC_SetAlarm_IT(&RtcHandle, &RTC_AlarmStructure, RTC_FORMAT_BIN);
@@ -1122,9 +2333,11 @@ void RTC_GetAlarm(alarm_t name, uint8_t *day, uint8_t *hours, uint8_t *minutes,
        */
       if ((initMode == MODE_BINARY_ONLY) || (initMode == MODE_BINARY_MIX)) {
         /* read the ALARM SSR register on SS[14:0] bits --> 0x7FFF */
-        *subSeconds = (((0x7fff - RTC_AlarmStructure.AlarmTime.SubSeconds + 1) & 0x7fff) * 1000) / fqce_apre;
+        *subSeconds = RTC_divRecip(((0x7fff - RTC_AlarmStructure.AlarmTime.SubSeconds + 1) & 0x7fff) * 1000,
+                                   fqce_apre, fqce_apre_recip);
       } else {
-        *subSeconds = ((predivSync - RTC_AlarmStructure.AlarmTime.SubSeconds) * 1000) / (predivSync + 1);
+        *subSeconds = RTC_divRecip((predivSync - RTC_AlarmStructure.AlarmTime.SubSeconds) * 1000,
+                                   predivSync + 1, predivSync_recip);
       }
     }
 #else
@@ -1154,6 +2367,26 @@ void RTC_GetAlarm(alarm_t name, uint8_t *day, uint8_t *hours, uint8_t *minutes,
   }
 }
 
+/**
+  * @brief Get RTC alarm subsecond in nb of ticks (no millisecond conversion)
+  * @param name: ALARM_A or ALARM_B if exists
+  * @retval nb of ticks elapsed in the second when the alarm matches
+  *         or 32bit nb of ticks in BIN mode
+  */
+uint32_t RTC_GetAlarmSubSecondTicks(alarm_t name)
+{
+  uint32_t ticks = 0;
+#if defined(RTC_SSR_SS)
+  RTC_AlarmTypeDef RTC_AlarmStructure;
+
+  HAL_RTC_GetAlarm(&RtcHandle, &RTC_AlarmStructure, name, RTC_FORMAT_BIN);
+  ticks = RTC_SubSecondsToTicks(RTC_AlarmStructure.AlarmTime.SubSeconds);
+#else
+  UNUSED(name);
+#endif /* RTC_SSR_SS */
+  return ticks;
+}
+
 /**
   * @brief Attach alarm callback.
   * @param func: pointer to the callback
@@ -1245,7 +2478,11 @@ void RTC_Alarm_IRQHandler(void)
     defined(STM32WBAxx) || defined(STM32WL3x)
   // In some cases, the same vector is used to manage WakeupTimer,
   // but with a dedicated HAL IRQHandler
+#ifdef ONESECOND_IRQn
+  RTC_WakeUpIRQHandler();
+#else
   HAL_RTCEx_WakeUpTimerIRQHandler(&RtcHandle);
+#endif /* ONESECOND_IRQn */
 #endif
 }
 
@@ -1259,16 +2496,26 @@ void RTC_Alarm_IRQHandler(void)
   */
 void attachSecondsIrqCallback(voidCallbackPtr func)
 {
-#if defined(STM32F1xx)
-  /* callback called on Seconds interrupt */
+  /* callback called on Seconds or wakeUp interrupt for One-Second purpose */
   RTCSecondsIrqCallback = func;
 
+  /* The One-Second interrupt is already running for the seconds counter */
+  if (!isSecondsCountEnabled) {
+    RTC_EnableSecondsIrq();
+  }
+}
+
+/**
+  * @brief Enable the One-Second interrupt
+  * @param None
+  * @retval None
+  */
+static void RTC_EnableSecondsIrq(void)
+{
+#if defined(STM32F1xx)
   HAL_RTCEx_SetSecond_IT(&RtcHandle);
   __HAL_RTC_SECOND_CLEAR_FLAG(&RtcHandle, RTC_FLAG_SEC);
 #else
-  /* callback called on wakeUp interrupt for One-Second purpose*/
-  RTCSecondsIrqCallback = func;
-
   /* for MCUs using the wakeup feature : irq each second */
 #if defined(RTC_WUTR_WUTOCLR)
   HAL_RTCEx_SetWakeUpTimer_IT(&RtcHandle, 0, RTC_WAKEUPCLOCK_CK_SPRE_16BITS, 0);
@@ -1289,7 +2536,9 @@ void attachSecondsIrqCallback(voidCallbackPtr func)
 void detachSecondsIrqCallback(void)
 {
 #if defined(STM32F1xx)
-  HAL_RTCEx_DeactivateSecond(&RtcHandle);
+  if (!isSecondsCountEnabled) {
+    HAL_RTCEx_DeactivateSecond(&RtcHandle);
+  }
 #else
   /* for MCUs using the wakeup feature : do not deactivate the WakeUp
      as it might be used for another reason than the One-Second purpose */
@@ -1298,6 +2547,770 @@ void detachSecondsIrqCallback(void)
   RTCSecondsIrqCallback = NULL;
 }
 
+/**
+  * @brief Start the RAM seconds counter, updated by the One-Second interrupt.
+  * @note  The counter value has to be set by RTC_SetSecondsCount().
+  * @param None
+  * @retval None
+  */
+void RTC_StartSecondsCount(void)
+{
+  if (!isSecondsCountEnabled) {
+    RTC_EnableSecondsIrq();
+    isSecondsCountEnabled = true;
+  }
+}
+
+/**
+  * @brief Stop the RAM seconds counter
+  * @param None
+  * @retval None
+  */
+void RTC_StopSecondsCount(void)
+{
+  isSecondsCountEnabled = false;
+#if defined(STM32F1xx)
+  if (RTCSecondsIrqCallback == NULL) {
+    HAL_RTCEx_DeactivateSecond(&RtcHandle);
+  }
+#endif /* STM32F1xx */
+}
+
+/**
+  * @brief Check if the RAM seconds counter is running
+  * @retval True if running else false
+  */
+bool RTC_IsSecondsCountEnabled(void)
+{
+  return isSecondsCountEnabled;
+}
+
+/**
+  * @brief Check if a One-Second event is pending (not yet handled by the interrupt)
+  * @retval True if pending else false
+  */
+bool RTC_IsSecondsIrqPending(void)
+{
+  /*
+   * The HAL clears the flag before or after the callback depending on the
+   * series: while its handler runs, the event is pending until the callback
+   */
+  if (secondsIrqActive) {
+    return !secondsIrqHandled;
+  }
+#if defined(STM32F1xx)
+  return (LL_RTC_IsActiveFlag_SEC(RtcHandle.Instance) != 0U);
+#else
+  return (LL_RTC_IsActiveFlag_WUT(RtcHandle.Instance) != 0U);
+#endif /* STM32F1xx */
+}
+
+/**
+  * @brief Set the RAM seconds counter value
+  * @note  To be called with interrupts disabled, the value must not include
+  *        a pending One-Second event (see RTC_IsSecondsIrqPending()).
+  * @param seconds: counter value
+  * @retval None
+  */
+void RTC_SetSecondsCount(uint32_t seconds)
+{
+  secondsCount = seconds;
+}
+
+/**
+  * @brief Get the RAM seconds counter value without any calendar access
+  * @note  A One-Second event not yet handled by the interrupt (masked
+  *        interrupts or higher priority context) is taken into account.
+  * @param subSeconds: optional pointer where to store the subseconds in ms
+  * @param subSecondTicks: optional pointer where to store the subseconds in ticks
+  * @retval counter value
+  */
+uint32_t RTC_GetSecondsCount(uint32_t *subSeconds, uint32_t *subSecondTicks)
+{
+  uint32_t count;
+  uint32_t ssr = 0;
+  bool pending;
+
+  do {
+    count = secondsCount;
+    pending = RTC_IsSecondsIrqPending();
+#if defined(RTC_SSR_SS)
+    ssr = READ_REG(RtcHandle.Instance->SSR);
+#endif /* RTC_SSR_SS */
+    /* Read again if a new second started in between */
+  } while ((count != secondsCount) || (pending != RTC_IsSecondsIrqPending()));
+
+  if (pending) {
+    count++;
+  }
+#if defined(RTC_SSR_SS)
+  if (subSeconds != NULL) {
+    *subSeconds = RTC_SubSecondsToMs(ssr);
+  }
+  if (subSecondTicks != NULL) {
+    *subSecondTicks = RTC_SubSecondsToTicks(ssr);
+  }
+#else
+  UNUSED(ssr);
+  if (subSeconds != NULL) {
+    *subSeconds = 0;
+  }
+  if (subSecondTicks != NULL) {
+    *subSecondTicks = 0;
+  }
+#endif /* RTC_SSR_SS */
+  return count;
+}
+#endif /* ONESECOND_IRQn */
+
+#if defined(RTC_LSI_TRIM_SUPPORT)
+/**
+  * @brief Enable the LSI frequency measurement at RTC initialization, the
+  *        prescalers are computed from the measured frequency.
+  * @note  Only when the prescalers are not set by the user.
+  * @param enable: true to measure the LSI frequency
+  * @retval None
+  */
+void RTC_SetLsiTrim(bool enable)
+{
+  lsiTrim = enable;
+}
+
+/**
+  * @brief Measure the RTC clock frequency against the system clock, by
+  *        timing RTC_MEASURE_TICKS ticks of the SubSecond register.
+  * @note  The RTC must be running. The accuracy is the one of the system
+  *        clock (HSE or HSI). Can be redefined, for example to use a timer
+  *        input capture or to inject a frequency.
+  * @retval RTC clock frequency in Hz, 0 if failed
+  */
+__weak uint32_t RTC_MeasureClock(void)
+{
+  uint32_t count = 0;
+  uint32_t ssr = READ_REG(RtcHandle.Instance->SSR);
+  uint32_t start = getCurrentMicros();
+  uint32_t now = start;
+  uint32_t timeout = (RTC_MEASURE_TICKS + 1) * 2 * 1000000U / (fqce_apre ? fqce_apre : 1);
+
+  /* Measure from an edge of the SubSecond register to another */
+  while (count <= RTC_MEASURE_TICKS) {
+    if (READ_REG(RtcHandle.Instance->SSR) != ssr) {
+      ssr = READ_REG(RtcHandle.Instance->SSR);
+      if (count == 0) {
+        start = now;
+      }
+      count++;
+    }
+    now = getCurrentMicros();
+    if ((now - start) > timeout) {
+      return 0;
+    }
+  }
+  return RTC_ClockFromMeasure(RTC_MEASURE_TICKS, predivAsync, now - start);
+}
+
+/**
+  * @brief Measure the LSI frequency and update the computed prescalers.
+  *        Can be called periodically to follow the LSI drift.
+  * @note  The current time is kept, the prescalers are written in the
+  *        initialization mode.
+  * @retval Measured frequency in Hz, 0 if not done
+  */
+uint32_t RTC_TrimLsi(void)
+{
+  uint32_t freq, asynch, synch;
+
+  if ((clkSrc != LSI_CLOCK) || !predivComputed) {
+    return 0;
+  }
+  freq = RTC_MeasureClock();
+  if (freq == 0) {
+    return 0;
+  }
+  uint32_t nominal = clkVal;
+  clkVal = freq;
+  RTC_computePrediv(&asynch, &synch);
+  /* The old phase is read by RTC_WritePrediv() before the factors are updated */
+  if (!RTC_WritePrediv(asynch, synch)) {
+    clkVal = nominal;
+    return 0;
+  }
+  RTC_setConversionFactors(predivAsync, predivSync);
+  return freq;
+}
+
+/**
+  * @brief Use the prescalers of the running RTC, trimmed before a reset
+  * @retval None
+  */
+static void RTC_LoadPrediv(void)
+{
+  if ((clkSrc == LSI_CLOCK) && predivComputed) {
+    predivAsync = LL_RTC_GetAsynchPrescaler(RtcHandle.Instance);
+    predivSync = LL_RTC_GetSynchPrescaler(RtcHandle.Instance);
+    predivSync_bits = (uint8_t)_log2(predivSync) + 1;
+    RtcHandle.Init.AsynchPrediv = predivAsync;
+    RtcHandle.Init.SynchPrediv = predivSync;
+    clkVal = (predivAsync + 1) * (predivSync + 1);
+    RTC_setConversionFactors(predivAsync, predivSync);
+  }
+}
+#endif /* RTC_LSI_TRIM_SUPPORT */
+
+#if defined(RTC_CALR_CALP)
+/**
+  * @brief Convert a smooth calibration register value in nb of pulses
+  * @param calr: CALP, CALW8, CALW16 and CALM bits
+  * @retval nb of RTCCLK pulses added (> 0) or masked (< 0) per 2^20 cycles
+  */
+static int32_t RTC_CalibToPulses(uint32_t calr)
+{
+  return ((calr & RTC_CALR_CALP) ? 512 : 0) - (int32_t)(calr & RTC_CALR_CALM);
+}
+#endif /* RTC_CALR_CALP */
+
+#if defined(RTC_CALIB_SUPPORT)
+/* Marker of a calibration saved in the RTC_BKP_CALIB backup register */
+#define RTC_CALIB_MARKER  0xC000U
+#define RTC_CALIB_OFFSET  512
+
+/**
+  * @brief Set the RTC smooth calibration and save it in the RTC_BKP_CALIB
+  *        backup register if defined, to be restored after an RTC init.
+  *        The shortest calibration cycle (8, 16 or 32 seconds) giving this
+  *        correction is selected.
+  * @note  On STM32F1xx the RTC can only be slowed down (-127 to 0 pulses).
+  *        A time slew in progress is kept if the sum fits in the register.
+  * @param pulses: nb of RTCCLK pulses to add (> 0) or mask (< 0) per 2^20
+  *        cycles (0.954 ppm each), -511 to +512
+  * @retval True if set else false
+  */
+bool RTC_SetCalibration(int32_t pulses)
+{
+  bool status;
+#if defined(STM32F1xx)
+  if ((pulses > 0) || (pulses < -(int32_t)BKP_RTCCR_CAL)) {
+    return false;
+  }
+  /* Period and plus pulses are not used on STM32F1xx */
+  status = (HAL_RTCEx_SetSmoothCalib(&RtcHandle, 0, 0, (uint32_t)(-pulses)) == HAL_OK);
+#else
+  uint32_t period, plusPulses, minusPulses;
+  int32_t total = pulses;
+
+  if ((pulses > 512) || (pulses < -511)) {
+    return false;
+  }
+  plusPulses = (pulses > 0) ? RTC_SMOOTHCALIB_PLUSPULSES_SET : RTC_SMOOTHCALIB_PLUSPULSES_RESET;
+  minusPulses = (pulses > 0) ? (uint32_t)(512 - pulses) : (uint32_t)(-pulses);
+  /* CALM[1:0] are stuck at 0 in 8 s cycle and CALM[0] in 16 s cycle */
+  if ((minusPulses & 0x3) == 0) {
+    period = RTC_SMOOTHCALIB_PERIOD_8SEC;
+  } else if ((minusPulses & 0x1) == 0) {
+    period = RTC_SMOOTHCALIB_PERIOD_16SEC;
+  } else {
+    period = RTC_SMOOTHCALIB_PERIOD_32SEC;
+  }
+#if defined(RTC_SLEW_SUPPORT)
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (slewSeconds != 0) {
+    /* Keep the slew rate on top of the new calibration */
+    total += RTC_CalibToPulses(READ_REG(RtcHandle.Instance->CALR)) - RTC_CalibToPulses(slewCalibBase);
+    if ((total > 512) || (total < -511)) {
+      slewSeconds = 0;
+      RTC_DisableSlewIrq();
+      total = pulses;
+    }
+    slewCalibBase = period | plusPulses | minusPulses;
+  }
+  __set_PRIMASK(primask);
+#endif /* RTC_SLEW_SUPPORT */
+  if (total != pulses) {
+    status = (HAL_RTCEx_SetSmoothCalib(&RtcHandle, RTC_SMOOTHCALIB_PERIOD_32SEC,
+                                       (total > 0) ? RTC_SMOOTHCALIB_PLUSPULSES_SET : RTC_SMOOTHCALIB_PLUSPULSES_RESET,
+                                       (total > 0) ? (uint32_t)(512 - total) : (uint32_t)(-total)) == HAL_OK);
+  } else {
+    status = (HAL_RTCEx_SetSmoothCalib(&RtcHandle, period, plusPulses, minusPulses) == HAL_OK);
+  }
+#endif /* STM32F1xx */
+#if defined(RTC_BKP_CALIB)
+  if (status) {
+    setBackupRegister(RTC_BKP_CALIB, RTC_CALIB_MARKER | (uint32_t)(pulses + RTC_CALIB_OFFSET));
+#if defined(RTC_BKP_FINGERPRINT)
+    RTC_SaveFingerprint();
+#endif /* RTC_BKP_FINGERPRINT */
+  }
+#endif /* RTC_BKP_CALIB */
+  return status;
+}
+
+/**
+  * @brief Get the RTC smooth calibration, without a time slew in progress
+  * @retval nb of RTCCLK pulses added (> 0) or masked (< 0) per 2^20 cycles
+  */
+int32_t RTC_GetCalibration(void)
+{
+#if defined(STM32F1xx)
+  return -(int32_t)READ_BIT(BKP->RTCCR, BKP_RTCCR_CAL);
+#else
+#if defined(RTC_SLEW_SUPPORT)
+  if (slewSeconds != 0) {
+    return RTC_CalibToPulses(slewCalibBase);
+  }
+#endif /* RTC_SLEW_SUPPORT */
+  return RTC_CalibToPulses(READ_REG(RtcHandle.Instance->CALR));
+#endif /* STM32F1xx */
+}
+
+#if defined(RTC_BKP_CALIB)
+/**
+  * @brief Restore the calibration saved in the RTC_BKP_CALIB backup register
+  * @retval None
+  */
+static void RTC_RestoreCalibration(void)
+{
+  uint32_t saved = getBackupRegister(RTC_BKP_CALIB) & 0xFFFF;
+
+  if ((saved & ~0x3FFU) == RTC_CALIB_MARKER) {
+    RTC_SetCalibration((int32_t)(saved & 0x3FFU) - RTC_CALIB_OFFSET);
+  }
+}
+#endif /* RTC_BKP_CALIB */
+#endif /* RTC_CALIB_SUPPORT */
+
+#if defined(RTC_SLEW_SUPPORT)
+/**
+  * @brief Slew the calendar time through the smooth calibration: the RTC runs
+  *        faster or slower until the offset is corrected, then the current
+  *        calibration is restored by the One-Second interrupt.
+  * @note  The correction rate is limited to about +/-488 ppm, so the window
+  *        is extended if needed. The part of the offset which cannot be
+  *        corrected with the calibration resolution is applied with a shift.
+  * @param ticks: nb of SubSecond ticks to advance (> 0) or delay (< 0) the calendar
+  * @param window: duration of the correction in seconds
+  * @retval True if started, false if nothing can be slewed (calibration
+  *         saturated) or if the remainder cannot be shifted
+  */
+bool RTC_StartSlew(int32_t ticks, uint32_t window)
+{
+  uint64_t nbTicks = (ticks < 0) ? (uint64_t)(-(int64_t)ticks) : (uint64_t)ticks;
+  uint32_t ticksPerSecond = predivSync + 1;
+  int32_t base, total, slew;
+  uint32_t nbPulses, seconds;
+  uint64_t remainder;
+
+  if ((nbTicks == 0) || (window == 0)) {
+    return false;
+  }
+  RTC_StopSlew();
+  if (slewSeconds == 0) {
+    slewCalibBase = READ_REG(RtcHandle.Instance->CALR) & (RTC_CALR_CALP | RTC_CALR_CALW8 | RTC_CALR_CALW16 | RTC_CALR_CALM);
+  }
+  /* Calibration in pulses added per 2^20 RTCCLK cycles */
+  base = RTC_CalibToPulses(slewCalibBase);
+  nbPulses = RTC_SlewPulses(nbTicks, window, ticksPerSecond);
+  total = base + ((ticks > 0) ? (int32_t)nbPulses : -(int32_t)nbPulses);
+  if (total > 512) {
+    total = 512;
+  } else if (total < -511) {
+    total = -511;
+  }
+  slew = total - base;
+  nbPulses = (slew < 0) ? (uint32_t)(-slew) : (uint32_t)slew;
+  seconds = RTC_SlewSeconds(nbTicks, nbPulses, ticksPerSecond);
+  remainder = nbTicks - RTC_SlewTicks(nbPulses, seconds, ticksPerSecond);
+
+  if (seconds == 0) {
+    /* The base calibration is saturated in this direction */
+    return false;
+  }
+#if defined(RTC_SHIFTR_SUBFS)
+  /* An advance cannot be shifted while a previous delay is pending */
+  if ((remainder >= ticksPerSecond)
+      || ((remainder != 0) && (ticks > 0) && RTC_IsSecondAhead(READ_REG(RtcHandle.Instance->SSR)))) {
+    return false;
+  }
+#endif /* RTC_SHIFTR_SUBFS */
+  if (HAL_RTCEx_SetSmoothCalib(&RtcHandle, RTC_SMOOTHCALIB_PERIOD_32SEC,
+                               (total > 0) ? RTC_SMOOTHCALIB_PLUSPULSES_SET : RTC_SMOOTHCALIB_PLUSPULSES_RESET,
+                               (total > 0) ? (uint32_t)(512 - total) : (uint32_t)(-total)) != HAL_OK) {
+    return false;
+  }
+  slewSeconds = seconds;
+  /* The One-Second interrupt is needed to end the slew */
+  if (!isSecondsCountEnabled && (RTCSecondsIrqCallback == NULL) && !slewSecondsIrq) {
+    RTC_EnableSecondsIrq();
+    slewSecondsIrq = true;
+  }
+#if defined(RTC_SHIFTR_SUBFS)
+  /* The part below the calibration resolution is shifted */
+  if ((remainder != 0) && !RTC_ShiftSubSeconds((ticks > 0) ? (int32_t)remainder : -(int32_t)remainder)) {
+    RTC_StopSlew();
+    return false;
+  }
+#else
+  UNUSED(remainder);
+#endif /* RTC_SHIFTR_SUBFS */
+  return true;
+}
+
+/**
+  * @brief Stop the time slew and restore the calibration
+  * @note  If the calibration cannot be written yet, its restore is deferred
+  *        to the next One-Second interrupt.
+  * @retval None
+  */
+void RTC_StopSlew(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (slewSeconds != 0) {
+    slewSeconds = RTC_EndSlew() ? 0 : 1;
+  }
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief Restore the calibration at the end of the time slew, and stop the
+  *        One-Second interrupt if only enabled for the slew
+  * @note  Called from the One-Second interrupt: the registers are written
+  *        directly, without waiting, and the HAL lock is not taken.
+  * @retval True if done, false if to retry later (pending calibration or
+  *         RTC handle in use)
+  */
+static bool RTC_EndSlew(void)
+{
+  if ((RtcHandle.Lock == HAL_LOCKED) || (LL_RTC_IsActiveFlag_RECALP(RtcHandle.Instance) != 0U)) {
+    return false;
+  }
+  LL_RTC_DisableWriteProtection(RtcHandle.Instance);
+  WRITE_REG(RtcHandle.Instance->CALR, slewCalibBase);
+  LL_RTC_EnableWriteProtection(RtcHandle.Instance);
+  RTC_DisableSlewIrq();
+  return true;
+}
+
+/**
+  * @brief Stop the One-Second interrupt if only enabled for the time slew
+  * @retval None
+  */
+static void RTC_DisableSlewIrq(void)
+{
+  if (slewSecondsIrq) {
+    slewSecondsIrq = false;
+    if (!isSecondsCountEnabled && (RTCSecondsIrqCallback == NULL)) {
+      LL_RTC_DisableWriteProtection(RtcHandle.Instance);
+      LL_RTC_DisableIT_WUT(RtcHandle.Instance);
+      LL_RTC_WAKEUP_Disable(RtcHandle.Instance);
+      LL_RTC_EnableWriteProtection(RtcHandle.Instance);
+    }
+  }
+}
+
+/**
+  * @brief Check if a time slew is in progress
+  * @retval True if in progress else false
+  */
+bool RTC_IsSlewing(void)
+{
+  return (slewSeconds != 0);
+}
+#endif /* RTC_SLEW_SUPPORT */
+
+#if defined(RTC_LSE_ASYNC_SUPPORT)
+/**
+  * @brief Start the LSE without waiting for it in RTC_init(): the RTC runs
+  *        from the LSI until RTC_HandoverLse() switches it to the LSE.
+  * @note  Only the LSE start is asynchronous, the switch is blocking (see
+  *        RTC_HandoverLse()).
+  * @param enable: true to start the LSE asynchronously
+  * @retval None
+  */
+void RTC_SetLseAsync(bool enable)
+{
+  lseAsync = enable;
+}
+
+/**
+  * @brief Check if the RTC runs from the LSI waiting for the LSE
+  * @retval True if the handover to the LSE is pending, else false
+  */
+bool RTC_IsLsePending(void)
+{
+  return lsePending;
+}
+
+/**
+  * @brief Check if the LSE is ready
+  * @retval True if ready, else false
+  */
+bool RTC_IsLseReady(void)
+{
+  return (__HAL_RCC_GET_FLAG(RCC_FLAG_LSERDY) != RESET);
+}
+
+/**
+  * @brief Switch the RTC from the LSI to the LSE once the LSE is ready.
+  *        The time elapsed while the LSE restarts after the backup domain
+  *        reset is not compensated here: once the caller has carried the
+  *        calendar forward, RTC_CatchUpAlarms() calls the alarms due meanwhile.
+  * @note  Blocking: the backup domain reset stops the LSE, the switch waits
+  *        for it to restart (up to 2 s). From thread context only.
+  * @retval True if the RTC has been switched to the LSE, else false
+  */
+bool RTC_HandoverLse(void)
+{
+  if (!lsePending || !RTC_IsLseReady()) {
+    return false;
+  }
+  lsePending = false;
+  clkSrc = LSE_CLOCK;
+  clkVal = lseClkVal;
+  clkConfigured = lseClkConfigured;
+  predivAsync = lsePredivAsync;
+  predivSync = lsePredivSync;
+  predivComputed = lsePredivComputed;
+  RTC_SwitchClock(LSE_CLOCK);
+  return true;
+}
+
+/**
+  * @brief Call the callback of each alarm due while the calendar has been
+  *        carried forward, as its hardware match has been skipped.
+  * @note  From thread context: the callbacks are called from it.
+  *        Not for the BIN mode, without calendar.
+  * @param from: nb of seconds since 1st January 2000 before, excluded
+  * @param to: nb of seconds since 1st January 2000 after, excluded
+  * @retval None
+  */
+void RTC_CatchUpAlarms(uint32_t from, uint32_t to)
+{
+  if (RTC_IsAlarmDue(ALARM_A, from, to) && (RTCUserCallback != NULL)) {
+    RTCUserCallback(callbackUserData);
+  }
+#ifdef RTC_ALARM_B
+  if (RTC_IsAlarmDue(ALARM_B, from, to) && (RTCUserCallbackB != NULL)) {
+    RTCUserCallbackB(callbackUserDataB);
+  }
+#endif
+}
+
+/**
+  * @brief Check if an alarm matches a second between two times
+  * @param name: ALARM_A or ALARM_B if exists
+  * @param from: nb of seconds since 1st January 2000, excluded
+  * @param to: nb of seconds since 1st January 2000, excluded
+  * @retval True if the alarm is set and matches between from and to
+  */
+static bool RTC_IsAlarmDue(alarm_t name, uint32_t from, uint32_t to)
+{
+  hourAM_PM_t period = HOUR_AM;
+  uint8_t mask = 0, day = 0, hours = 0, minutes = 0, seconds = 0;
+
+  if ((initMode == MODE_BINARY_ONLY) || !RTC_IsAlarmSet(name)) {
+    return false;
+  }
+  RTC_GetAlarm(name, &day, &hours, &minutes, &seconds, NULL, &period, &mask);
+  if (initFormat == HOUR_FORMAT_12) {
+    hours = RTC_Hours24(hours, period == HOUR_PM);
+  }
+  return RTC_AlarmDue(from, to, day, hours, minutes, seconds, mask);
+}
+
+#if defined(RTC_LSECSS_SUPPORT)
+/**
+  * @brief Enable the LSE clock security system: on an LSE failure, the RTC
+  *        falls back to the LSI (see RTC_CheckLseCss()).
+  * @note  The LSE CSS interrupt is not used: the failure is polled.
+  * @param enable: true to enable the LSE CSS
+  * @retval None
+  */
+void RTC_SetLseCss(bool enable)
+{
+  lseCss = enable;
+  if (!enable) {
+    HAL_RCCEx_DisableLSECSS();
+  } else if (LL_RTC_IsActiveFlag_INITS(RtcHandle.Instance)
+             && (RTC_GetActiveClockSource() == LSE_CLOCK)) {
+    RTC_StartLseCss();
+  }
+}
+
+/**
+  * @brief Start the LSE CSS if enabled and the RTC runs from the LSE
+  * @retval None
+  */
+static void RTC_StartLseCss(void)
+{
+  if (lseCss && !lseFailed && !lsePending && (clkSrc == LSE_CLOCK)) {
+    /* The LSE CSS uses the LSI */
+    enableClock(LSI_CLOCK);
+    HAL_RCCEx_EnableLSECSS();
+    RTC_SaveLseReference();
+  }
+}
+
+/**
+  * @brief Read the calendar with the SysTick, the reference to carry the
+  *        calendar forward after an LSE failure
+  * @retval None
+  */
+static void RTC_SaveLseReference(void)
+{
+  RTC_GetDateTime(&lseRefTime);
+  lseRefTick = HAL_GetTick();
+  lseRefValid = true;
+}
+
+/**
+  * @brief Check the LSE CSS failure flag and fall back to the LSI on a
+  *        failure, else refresh the reference of the calendar if written
+  *        since or older than RTC_LSE_REF_INTERVAL.
+  * @note  Must be called periodically from thread context, the fallback is
+  *        blocking. The RTC is stopped from the failure to this call.
+  * @retval True if the LSE has failed, else false
+  */
+bool RTC_CheckLseCss(void)
+{
+  if (lseCss && !lseFailed && !lsePending && rtcInitialized && (clkSrc == LSE_CLOCK)) {
+    if (__HAL_RCC_GET_FLAG(RCC_FLAG_LSECSSD) != RESET) {
+      RTC_LseFailover();
+    } else if (!lseRefValid || ((HAL_GetTick() - lseRefTick) >= RTC_LSE_REF_INTERVAL)) {
+      RTC_SaveLseReference();
+    }
+  }
+  return lseFailed;
+}
+
+/**
+  * @brief Check if the RTC runs from the LSI after an LSE failure
+  * @retval True if the time accuracy is degraded, else false
+  */
+bool RTC_IsLseFailed(void)
+{
+  return lseFailed;
+}
+
+/**
+  * @brief Check if the calendar has not been carried forward over the LSE
+  *        outage (no valid reference, BIN or MIX mode, or write failure):
+  *        it then restarted from the time of the failure.
+  * @retval True if the time of the outage is lost, else false
+  */
+bool RTC_IsLseTimeLost(void)
+{
+  return lseTimeLost;
+}
+
+/**
+  * @brief Fall back to the LSI after an LSE failure, with prescalers computed
+  *        for the LSI. The calendar is carried forward from the last reference
+  *        (see RTC_CheckLseCss()) with the SysTick (BCD mode only), calling
+  *        the alarms due over the outage, else it restarts from the time of
+  *        the failure.
+  *        Until the next reset, RTC_init() keeps the LSI.
+  * @note  Blocking, must be called from thread context. Called by
+  *        RTC_CheckLseCss(), or to inject a failure.
+  * @retval None
+  */
+void RTC_LseFailover(void)
+{
+  dateTime_t stopped;
+  bool refValid;
+
+  if ((clkSrc != LSE_CLOCK) || lseFailed || lsePending) {
+    return;
+  }
+  /* The LSE CSS and the LSE must be off before the backup domain reset */
+  HAL_RCCEx_DisableLSECSS();
+  __HAL_RCC_LSE_CONFIG(RCC_LSE_OFF);
+  lseFailed = true;
+  /* The calendar stopped with the LSE */
+  RTC_GetDateTime(&stopped);
+  /* Restoring the calendar below would invalidate the reference */
+  refValid = lseRefValid;
+  lseTimeLost = true;
+  RTC_SetClockSource(LSI_CLOCK);
+  RTC_setPrediv(PREDIVA_MAX + 1, PREDIVS_MAX + 1);
+  RTC_SwitchClock(LSI_CLOCK);
+  if (refValid) {
+    uint32_t elapsed = HAL_GetTick() - lseRefTick;
+    uint64_t refMs = RTC_Y2kMs(&lseRefTime);
+    uint64_t stoppedMs = RTC_Y2kMs(&stopped);
+    /* Not a reference of this calendar if written since */
+    if ((stoppedMs >= refMs) && (stoppedMs <= (refMs + elapsed + 1000U))
+        && RTC_AdvanceTime(&lseRefTime, elapsed)) {
+      dateTime_t advanced;
+      lseTimeLost = false;
+      RTC_GetDateTime(&advanced);
+      /* The hardware has not matched the alarms over the outage */
+      RTC_CatchUpAlarms((uint32_t)(stoppedMs / 1000U), (uint32_t)(RTC_Y2kMs(&advanced) / 1000U));
+    }
+    lseRefValid = false;
+  }
+  if (RTCLseFailureCallback != NULL) {
+    RTCLseFailureCallback(callbackLseFailureData);
+  }
+}
+
+/**
+  * @brief Attach the LSE failure callback, called in thread context once the
+  *        RTC runs from the LSI
+  * @param func: pointer to the callback
+  * @param data: pointer to the data passed to the callback
+  * @retval None
+  */
+void attachLseFailureCallback(voidCallbackPtr func, void *data)
+{
+  RTCLseFailureCallback = func;
+  callbackLseFailureData = data;
+}
+
+/**
+  * @brief Set the calendar to a reference date and time carried forward,
+  *        saturated to the RTC range (BCD mode only)
+  * @param ref: reference date and time
+  * @param ms: nb of milliseconds elapsed since the reference
+  * @retval True if the calendar is set, else false
+  */
+static bool RTC_AdvanceTime(const dateTime_t *ref, uint32_t ms)
+{
+  dateTime_t dateTime = *ref;
+  uint64_t y2kMs = RTC_Y2kMs(ref) + ms;
+
+  if (initMode != MODE_BINARY_NONE) {
+    return false;
+  }
+  if (y2kMs > 3155759999999ULL) {
+    /* 31st December 2099, 23:59:59.999 */
+    y2kMs = 3155759999999ULL;
+  }
+  RTC_Y2kMsToDateTime(&dateTime, y2kMs);
+  return RTC_SetDateTime(&dateTime);
+}
+#endif /* RTC_LSECSS_SUPPORT */
+#endif /* RTC_LSE_ASYNC_SUPPORT */
+
+#ifdef ONESECOND_IRQn
+/**
+  * @brief  Count the One-Second event from the HAL callback
+  * @note   The counter and the handled state are updated at once for
+  *         RTC_GetSecondsCount(), which may run in a higher priority interrupt.
+  * @param  None
+  * @retval None
+  */
+static void RTC_SecondsIrqHandled(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (isSecondsCountEnabled) {
+    secondsCount++;
+  }
+  secondsIrqHandled = true;
+  __set_PRIMASK(primask);
+}
+
 #if defined(STM32F1xx)
 /**
   * @brief  Seconds interrupt callback.
@@ -1308,6 +3321,7 @@ void HAL_RTCEx_RTCEventCallback(RTC_HandleTypeDef *hrtc)
 {
   UNUSED(hrtc);
 
+  RTC_SecondsIrqHandled();
   if (RTCSecondsIrqCallback != NULL) {
     RTCSecondsIrqCallback(NULL);
   }
@@ -1320,7 +3334,11 @@ void HAL_RTCEx_RTCEventCallback(RTC_HandleTypeDef *hrtc)
   */
 void RTC_IRQHandler(void)
 {
+  secondsIrqHandled = false;
+  /* Only a pending event is tracked: the vector may be shared */
+  secondsIrqActive = RTC_IsSecondsIrqPending();
   HAL_RTCEx_RTCIRQHandler(&RtcHandle);
+  secondsIrqActive = false;
 }
 
 #else
@@ -1333,6 +3351,16 @@ void HAL_RTCEx_WakeUpTimerEventCallback(RTC_HandleTypeDef *hrtc)
 {
   UNUSED(hrtc);
 
+  RTC_SecondsIrqHandled();
+#if defined(RTC_SLEW_SUPPORT)
+  if (slewSeconds != 0) {
+    slewSeconds--;
+    if ((slewSeconds == 0) && !RTC_EndSlew()) {
+      /* Retry at the next second */
+      slewSeconds = 1;
+    }
+  }
+#endif /* RTC_SLEW_SUPPORT */
   if (RTCSecondsIrqCallback != NULL) {
     RTCSecondsIrqCallback(NULL);
   }
@@ -1345,7 +3373,25 @@ void HAL_RTCEx_WakeUpTimerEventCallback(RTC_HandleTypeDef *hrtc)
   */
 void RTC_WKUP_IRQHandler(void)
 {
+  RTC_WakeUpIRQHandler();
+}
+
+/**
+  * @brief  Handle the wakeup interrupt through the HAL, which clears the
+  *         wakeup flag and calls HAL_RTCEx_WakeUpTimerEventCallback().
+  * @note   While it runs, RTC_IsSecondsIrqPending() does not rely on the flag,
+  *         so that RTC_GetSecondsCount() never sees the new second neither
+  *         counted nor pending, even from a higher priority interrupt.
+  * @param  None
+  * @retval None
+  */
+static void RTC_WakeUpIRQHandler(void)
+{
+  secondsIrqHandled = false;
+  /* Only a pending event is tracked: the vector may be shared */
+  secondsIrqActive = RTC_IsSecondsIrqPending();
   HAL_RTCEx_WakeUpTimerIRQHandler(&RtcHandle);
+  secondsIrqActive = false;
 }
 #endif /* STM32F1xx */
 #endif /* ONESECOND_IRQn */
@@ -1361,6 +3407,12 @@ void attachSubSecondsUnderflowIrqCallback(voidCallbackPtr func)
   /* Callback called on SSRU interrupt */
   RTCSubSecondsUnderflowIrqCallback = func;
 
+  if (!isSubSecondsUnderflowIrqSet) {
+    /* From now, the ticks wrap count is maintained by the SSRU interrupt */
+    (void)RTC_UpdateTicksWrap();
+    isSubSecondsUnderflowIrqSet = true;
+  }
+
   /* Enable the IRQ that will trig the one-second interrupt */
   if (HAL_RTCEx_SetSSRU_IT(&RtcHandle) != HAL_OK) {
     Error_Handler();
@@ -1381,11 +3433,17 @@ void detachSubSecondsUnderflowIrqCallback(void)
     Error_Handler();
   }
   HAL_NVIC_DisableIRQ(TAMP_STAMP_LSECSS_SSRU_IRQn);
+  /* Back to the wrap check at each RTC_GetTicks() call */
+  ticksLast = UINT32_MAX - READ_REG(RtcHandle.Instance->SSR);
+  isSubSecondsUnderflowIrqSet = false;
 }
 
 void HAL_RTCEx_SSRUEventCallback(RTC_HandleTypeDef *hrtc)
 {
   (void)hrtc;
+  if (isSubSecondsUnderflowIrqSet) {
+    ticksWrapCount++;
+  }
   if (RTCSubSecondsUnderflowIrqCallback != NULL) {
     RTCSubSecondsUnderflowIrqCallback(NULL);
   }
@@ -88,6 +88,19 @@ typedef enum {
 #endif
 } alarm_t;
 
+typedef struct {
+  uint8_t year;       /* 0-99 */
+  uint8_t month;      /* 1-12 */
+  uint8_t day;        /* 1-31 */
+  uint8_t wday;       /* 1-7 */
+  uint8_t hours;      /* 0-12 or 0-23 depends on the hours mode */
+  uint8_t minutes;    /* 0-59 */
+  uint8_t seconds;    /* 0-59 */
+  hourAM_PM_t period; /* HOUR_AM or HOUR_PM */
+  uint32_t subSeconds;/* 0-999 milliseconds or 32bit nb of milliseconds in BIN mode */
+  uint32_t subSecondTicks; /* nb of SubSecond register ticks elapsed (0 if not supported) */
+} dateTime_t;
+
 typedef void(*voidCallbackPtr)(void *);
 
 /* Exported constants --------------------------------------------------------*/
@@ -101,6 +114,23 @@ typedef void(*voidCallbackPtr)(void *);
 #endif
 #endif /* STM32F1xx */
 
+/*
+ * Define RTC_BKP_FINGERPRINT (for example LL_RTC_BKP_DR5) to store the fingerprint
+ * of the RTC configuration in 32 bits of backup memory, compared by RTC_init() to
+ * skip the configuration probes on a warm start (not available for STM32F1xx).
+ * Not defined by default: the backup registers are left to the application.
+ */
+#if defined(RTC_BKP_FINGERPRINT) && defined(STM32F1xx)
+#undef RTC_BKP_FINGERPRINT
+#endif
+
+/*
+ * Define RTC_BKP_DRIFT (for example LL_RTC_BKP_DR1) to store the drift learning
+ * state in backup memory: 3 consecutive 32 bits reg. from RTC_BKP_DRIFT
+ * (STM32F1xx: 6 consecutive 16 bits reg.).
+ * Not defined by default: the backup registers are left to the application.
+ */
+
 /* Interrupt priority */
 #ifndef RTC_IRQ_PRIO
 #define RTC_IRQ_PRIO       2
@@ -116,6 +146,31 @@ typedef void(*voidCallbackPtr)(void *);
 #endif
 #define HSE_RTC_MAX 1000000U
 
+/*
+ * HSE division factor for the RTC clock, to supply a clock lower than or
+ * equal to HSE_RTC_MAX. Constant expression, HZ is the HSE frequency.
+ */
+#if defined(STM32F1xx)
+/* HSE max is 16 MHZ divided by 128 --> 125 KHz */
+#define RTC_HSE_DIV(HZ) 128U
+#define RTC_HSE_DIV_MAX 128U
+#elif defined(RCC_RTCCLKSOURCE_HSE_DIV32) && !defined(RCC_RTCCLKSOURCE_HSE_DIV31)
+#define RTC_HSE_DIV(HZ) 32U
+#define RTC_HSE_DIV_MAX 32U
+#elif !defined(RCC_RTCCLKSOURCE_HSE_DIV31)
+#define RTC_HSE_DIV(HZ) ((((HZ) / 2) <= HSE_RTC_MAX) ? 2U : (((HZ) / 4) <= HSE_RTC_MAX) ? 4U : \
+                         (((HZ) / 8) <= HSE_RTC_MAX) ? 8U : 16U)
+#define RTC_HSE_DIV_MAX 16U
+#else
+/* Smallest divider from 2 */
+#define RTC_HSE_DIV(HZ) ((((HZ) / 2) <= HSE_RTC_MAX) ? 2U : (((HZ) / (HSE_RTC_MAX + 1)) + 1))
+#if defined(RCC_RTCCLKSOURCE_HSE_DIV63)
+#define RTC_HSE_DIV_MAX 63U
+#else
+#define RTC_HSE_DIV_MAX 31U
+#endif
+#endif /* STM32F1xx */
+
 #if !defined(STM32F1xx)
 #if !defined(RTC_PRER_PREDIV_S) || !defined(RTC_PRER_PREDIV_S)
 #error "Unknown Family - unknown synchronous prescaler"
@@ -164,6 +219,40 @@ typedef void(*voidCallbackPtr)(void *);
 // no One-Second IRQ available for the series
 #endif /* STM32F1xx || etc */
 
+#if !defined(STM32F1xx) && defined(RTC_SSR_SS)
+// LSI frequency measured with the SubSecond register against the system clock
+#define RTC_LSI_TRIM_SUPPORT
+/* nb of SubSecond register ticks of the measure, 64 ticks: 250ms at 256Hz */
+#if !defined(RTC_MEASURE_TICKS)
+#define RTC_MEASURE_TICKS 64
+#endif
+#endif /* !STM32F1xx && RTC_SSR_SS */
+
+#if defined(RTC_CALR_CALP) || defined(BKP_RTCCR_CAL)
+// Smooth calibration (STM32F1xx: slow down only, with the BKP RTC clock calibration register)
+#define RTC_CALIB_SUPPORT
+/*
+ * Define RTC_BKP_CALIB (for example LL_RTC_BKP_DR4) to select 16 bits in backup
+ * memory to store the calibration restored after an RTC init.
+ * Not defined by default: the backup registers are left to the application.
+ */
+#endif /* RTC_CALR_CALP || BKP_RTCCR_CAL */
+
+#if defined(RTC_CALR_CALP) && defined(ONESECOND_IRQn)
+// Time slew through the smooth calibration, ended by the One-Second interrupt
+#define RTC_SLEW_SUPPORT
+#endif /* RTC_CALR_CALP && ONESECOND_IRQn */
+
+#if !defined(STM32F1xx)
+// Asynchronous LSE startup: the RTC runs from the LSI until the LSE is ready,
+// then the switch to the LSE (backup domain reset) is blocking
+#define RTC_LSE_ASYNC_SUPPORT
+#if defined(RCC_BDCR_LSECSSON)
+// LSE clock security system: the RTC falls back to the LSI on an LSE failure
+#define RTC_LSECSS_SUPPORT
+#endif /* RCC_BDCR_LSECSSON */
+#endif /* !STM32F1xx */
+
 #if defined(STM32F1xx) && !defined(IS_RTC_WEEKDAY)
 /* Compensate missing HAL definition */
 #define IS_RTC_WEEKDAY(WEEKDAY) (((WEEKDAY) == RTC_WEEKDAY_MONDAY)    || \
@@ -182,6 +271,11 @@ typedef void(*voidCallbackPtr)(void *);
 /* Exported functions ------------------------------------------------------- */
 RTC_HandleTypeDef *RTC_GetHandle(void);
 void RTC_SetClockSource(sourceClock_t source);
+void RTC_SetClockConfig(sourceClock_t source, uint32_t clock, uint32_t asynch, uint32_t synch);
+#if !defined(STM32F1xx)
+uint32_t RTC_SetSubSecondResolution(uint32_t ticksPerSecond);
+uint32_t RTC_GetRelativeCurrent(void);
+#endif /* !STM32F1xx */
 void RTC_getPrediv(uint32_t *asynch, uint32_t *synch);
 void RTC_setPrediv(uint32_t asynch, uint32_t synch);
 
@@ -189,23 +283,74 @@ bool RTC_init(hourFormat_t format, binaryMode_t mode, sourceClock_t source, bool
 void RTC_DeInit(bool reset_cb);
 bool RTC_IsConfigured(void);
 
-void RTC_SetTime(uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSeconds, hourAM_PM_t period);
+bool RTC_SetTime(uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSeconds, hourAM_PM_t period);
 void RTC_GetTime(uint8_t *hours, uint8_t *minutes, uint8_t *seconds, uint32_t *subSeconds, hourAM_PM_t *period);
 
-void RTC_SetDate(uint8_t year, uint8_t month, uint8_t day, uint8_t wday);
+bool RTC_SetDate(uint8_t year, uint8_t month, uint8_t day, uint8_t wday);
 void RTC_GetDate(uint8_t *year, uint8_t *month, uint8_t *day, uint8_t *wday);
 
+bool RTC_SetDateTime(const dateTime_t *dateTime);
+#if defined(RTC_SHIFTR_SUBFS)
+bool RTC_ShiftSubSeconds(int32_t ticks);
+bool RTC_SetSubSeconds(uint32_t subSeconds);
+#endif /* RTC_SHIFTR_SUBFS */
+void RTC_GetDateTime(dateTime_t *dateTime);
+uint32_t RTC_GetReadCount(void);
+
+uint32_t RTC_GetTickFrequency(void);
+uint32_t RTC_GetTicksPerSecond(void);
+#if defined(RTC_BINARY_NONE)
+uint64_t RTC_GetTicks(void);
+#endif /* RTC_BINARY_NONE */
+
 void RTC_StartAlarm(alarm_t name, uint8_t day, uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSeconds, hourAM_PM_t period, uint8_t mask);
 void RTC_StartAlarm64(alarm_t name, uint8_t day, uint8_t hours, uint8_t minutes, uint8_t seconds, uint64_t subSeconds, hourAM_PM_t period, uint8_t mask);
+void RTC_StartAlarmTicks(alarm_t name, uint8_t day, uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSecondTicks, hourAM_PM_t period, uint8_t mask);
 void RTC_StopAlarm(alarm_t name);
 bool RTC_IsAlarmSet(alarm_t name);
 void RTC_GetAlarm(alarm_t name, uint8_t *day, uint8_t *hours, uint8_t *minutes, uint8_t *seconds, uint32_t *subSeconds, hourAM_PM_t *period, uint8_t *mask);
+uint32_t RTC_GetAlarmSubSecondTicks(alarm_t name);
 void attachAlarmCallback(voidCallbackPtr func, void *data, alarm_t name);
 void detachAlarmCallback(alarm_t name);
 #ifdef ONESECOND_IRQn
 void attachSecondsIrqCallback(voidCallbackPtr func);
 void detachSecondsIrqCallback(void);
+void RTC_StartSecondsCount(void);
+void RTC_StopSecondsCount(void);
+bool RTC_IsSecondsCountEnabled(void);
+bool RTC_IsSecondsIrqPending(void);
+void RTC_SetSecondsCount(uint32_t seconds);
+uint32_t RTC_GetSecondsCount(uint32_t *subSeconds, uint32_t *subSecondTicks);
 #endif /* ONESECOND_IRQn */
+#if defined(RTC_LSI_TRIM_SUPPORT)
+void RTC_SetLsiTrim(bool enable);
+uint32_t RTC_TrimLsi(void);
+uint32_t RTC_MeasureClock(void);
+#endif /* RTC_LSI_TRIM_SUPPORT */
+#if defined(RTC_CALIB_SUPPORT)
+bool RTC_SetCalibration(int32_t pulses);
+int32_t RTC_GetCalibration(void);
+#endif /* RTC_CALIB_SUPPORT */
+#if defined(RTC_SLEW_SUPPORT)
+bool RTC_StartSlew(int32_t ticks, uint32_t window);
+void RTC_StopSlew(void);
+bool RTC_IsSlewing(void);
+#endif /* RTC_SLEW_SUPPORT */
+#if defined(RTC_LSE_ASYNC_SUPPORT)
+void RTC_SetLseAsync(bool enable);
+bool RTC_IsLsePending(void);
+bool RTC_IsLseReady(void);
+bool RTC_HandoverLse(void);
+void RTC_CatchUpAlarms(uint32_t from, uint32_t to);
+#endif /* RTC_LSE_ASYNC_SUPPORT */
+#if defined(RTC_LSECSS_SUPPORT)
+void RTC_SetLseCss(bool enable);
+bool RTC_CheckLseCss(void);
+bool RTC_IsLseFailed(void);
+bool RTC_IsLseTimeLost(void);
+void RTC_LseFailover(void);
+void attachLseFailureCallback(voidCallbackPtr func, void *data);
+#endif /* RTC_LSECSS_SUPPORT */
 #ifdef STM32WLxx
 void attachSubSecondsUnderflowIrqCallback(voidCallbackPtr func);
 void detachSubSecondsUnderflowIrqCallback(void);
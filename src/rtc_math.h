@@ -0,0 +1,565 @@
+/**
+  ******************************************************************************
+  * @file    rtc_math.h
+  * @brief   Computations of the RTC driver without any register access,
+  *          shared by rtc.c and STM32RTC.cpp and checked by the host tests
+  *          of the tests folder.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; COPYRIGHT(c) 2020 STMicroelectronics</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without modification,
+  * are permitted provided that the following conditions are met:
+  *   1. Redistributions of source code must retain the above copyright notice,
+  *      this list of conditions and the following disclaimer.
+  *   2. Redistributions in binary form must reproduce the above copyright notice,
+  *      this list of conditions and the following disclaimer in the documentation
+  *      and/or other materials provided with the distribution.
+  *   3. Neither the name of STMicroelectronics nor the names of its contributors
+  *      may be used to endorse or promote products derived from this software
+  *      without specific prior written permission.
+  *
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __RTC_MATH_H
+#define __RTC_MATH_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Constant expressions in C++, so that the host tests check them with
+ * static_assert, plain inline functions in C.
+ * Every local variable must be initialized (C++14 constexpr).
+ */
+#ifdef __cplusplus
+#define RTC_CONSTEXPR static constexpr
+#else
+#define RTC_CONSTEXPR static inline
+#endif
+
+/* Calendar date and time in the RTC range (2000-2099) */
+typedef struct {
+  uint8_t year;       /* 0-99 */
+  uint8_t month;      /* 1-12 */
+  uint8_t day;        /* 1-31 */
+  uint8_t wday;       /* 1-7 (monday-sunday) */
+  uint8_t hours;      /* 0-23 */
+  uint8_t minutes;    /* 0-59 */
+  uint8_t seconds;    /* 0-59 */
+} civilTime_t;
+
+/* Crystal drift estimate, weighted by the measure duration */
+typedef struct {
+  int32_t  ppb;       /* > 0 if the crystal is fast */
+  uint16_t weight;    /* in minutes of measure */
+  uint8_t  outliers;  /* nb of consecutive rejected measures */
+} driftEstimate_t;
+
+/* Limits of the drift learning */
+typedef struct {
+  uint32_t minInterval; /* minimum duration in seconds of a measure */
+  int32_t  outlierPpb;  /* maximum deviation in ppb of a measure from the estimate */
+  uint8_t  maxOutliers; /* nb of consecutive rejected measures to learn again */
+  uint16_t window;      /* maximum weight of the estimate in minutes of measure */
+} driftLimits_t;
+
+/**
+  * @brief Convert the 4 BCD bytes of a word in binary at once:
+  *        each byte 16 * tens + units becomes 10 * tens + units
+  * @param bcd: 4 BCD bytes (each 0x00-0x99)
+  * @retval 4 binary bytes
+  */
+RTC_CONSTEXPR uint32_t RTC_Bcd2Bin(uint32_t bcd)
+{
+  return bcd - (6U * ((bcd >> 4) & 0x0F0F0F0FU));
+}
+
+/**
+  * @brief Convert a binary byte in BCD
+  * @param value: 0-99
+  * @retval BCD byte
+  */
+RTC_CONSTEXPR uint32_t RTC_Bin2Bcd(uint8_t value)
+{
+  return ((uint32_t)(value / 10U) << 4) | (value % 10U);
+}
+
+/**
+  * @brief Build the time register value (RTC_TR layout, checked in rtc.c)
+  * @param hours: 0-12 or 0-23 depends on the hours mode
+  * @param minutes: 0-59
+  * @param seconds: 0-59
+  * @param pm: true for a PM hour in 12 hours mode
+  * @retval time register value
+  */
+RTC_CONSTEXPR uint32_t RTC_PackTime(uint8_t hours, uint8_t minutes, uint8_t seconds, bool pm)
+{
+  return (RTC_Bin2Bcd(hours) << 16) | (RTC_Bin2Bcd(minutes) << 8) | RTC_Bin2Bcd(seconds)
+         | ((pm) ? (1UL << 22) : 0U);
+}
+
+/**
+  * @brief Build the date register value (RTC_DR layout, checked in rtc.c)
+  * @param year: 0-99
+  * @param month: 1-12
+  * @param day: 1-31
+  * @param wday: 1-7
+  * @retval date register value
+  */
+RTC_CONSTEXPR uint32_t RTC_PackDate(uint8_t year, uint8_t month, uint8_t day, uint8_t wday)
+{
+  return (RTC_Bin2Bcd(year) << 16) | ((uint32_t)wday << 13) | (RTC_Bin2Bcd(month) << 8) | RTC_Bin2Bcd(day);
+}
+
+/**
+  * @brief Check if the calendar second changed between two SubSecond register reads
+  * @param mix: true in MIX mode, false in BCD mode
+  * @param predivS: synchronous prescaler value
+  * @param ssrStart: SubSecond register value read before the calendar registers
+  * @param ssrEnd: SubSecond register value read after the calendar registers
+  * @retval True if a new second started in between
+  */
+RTC_CONSTEXPR bool RTC_SecondRollover(bool mix, uint32_t predivS, uint32_t ssrStart, uint32_t ssrEnd)
+{
+  /*
+   * BCD mode: the downcounter is reloaded with PREDIV_S at each new second.
+   * MIX mode: the free-running downcounter carries the second above the PREDIV_S bits.
+   */
+  return (mix) ? (((ssrStart ^ ssrEnd) & ~predivS) != 0U) : (ssrEnd > ssrStart);
+}
+
+/**
+  * @brief Convert the BCD mode SubSecond register value in elapsed ticks
+  * @param predivS: synchronous prescaler value
+  * @param ssr: SubSecond register value
+  * @retval nb of ticks elapsed in the second, 0-predivS
+  * @note  A shift delaying the calendar (SUBFS) may leave the SubSecond register
+  *        above predivS until the next second: the calendar registers are then
+  *        one second ahead (see RTC_SecondAhead()) and the elapsed ticks are
+  *        counted from the previous second.
+  */
+RTC_CONSTEXPR uint32_t RTC_SsrToTicks(uint32_t predivS, uint32_t ssr)
+{
+  return (ssr > predivS) ? ((2U * predivS) + 1U - ssr) : (predivS - ssr);
+}
+
+/**
+  * @brief Check if the BCD mode calendar registers are one second ahead
+  * @param predivS: synchronous prescaler value
+  * @param ssr: SubSecond register value read with the calendar registers
+  * @retval True if one second must be taken back from the calendar registers
+  */
+RTC_CONSTEXPR bool RTC_SecondAhead(uint32_t predivS, uint32_t ssr)
+{
+  return ssr > predivS;
+}
+
+/**
+  * @brief Get the number of days of a year before the first day of a month
+  * @param month: 1-12
+  * @param leap: true for a leap year
+  * @retval number of days, 0 if the month is invalid
+  */
+RTC_CONSTEXPR uint32_t RTC_DaysBeforeMonth(uint8_t month, bool leap)
+{
+  /* 30.58 days per month on average, February is 2 days short (1 if leap) */
+  return ((month < 1) || (month > 12)) ? 0U :
+         ((((367U * month) - 362U) / 12U) - ((month <= 2) ? 0U : ((leap) ? 1U : 2U)));
+}
+
+/**
+  * @brief Get the number of days since 1st January 2000
+  * @note  Only valid for the RTC range (2000-2099), where each year
+  *        divisible by 4 is a leap year.
+  * @param year: 0-99
+  * @param month: 1-12
+  * @param day: 1-31
+  * @retval number of days
+  */
+RTC_CONSTEXPR uint32_t RTC_DaysFromCivil(uint8_t year, uint8_t month, uint8_t day)
+{
+  return (365U * year) + ((year + 3U) / 4U) + RTC_DaysBeforeMonth(month, (year & 3U) == 0) + day - 1U;
+}
+
+/**
+  * @brief Get the number of seconds since 1st January 2000 of a calendar date and time
+  * @param year: 0-99
+  * @param month: 1-12
+  * @param day: 1-31
+  * @param hours: 0-23
+  * @param minutes: 0-59
+  * @param seconds: 0-59
+  * @retval number of seconds, fits in 32bit in the RTC range (2000-2099)
+  */
+RTC_CONSTEXPR uint32_t RTC_Y2kSeconds(uint8_t year, uint8_t month, uint8_t day,
+                                      uint8_t hours, uint8_t minutes, uint8_t seconds)
+{
+  return (RTC_DaysFromCivil(year, month, day) * 86400U) + (hours * 3600U) + (minutes * 60U) + seconds;
+}
+
+/**
+  * @brief Convert hours of the 12 hours format in the 24 hours format
+  * @param hours: 1-12
+  * @param pm: true for PM
+  * @retval hours: 0-23
+  */
+RTC_CONSTEXPR uint8_t RTC_Hours24(uint8_t hours, bool pm)
+{
+  return (uint8_t)((hours % 12U) + (pm ? 12U : 0U));
+}
+
+/**
+  * @brief Convert hours of the 24 hours format in the 12 hours format
+  * @param hours: 0-23, PM from 12
+  * @retval hours: 1-12
+  */
+RTC_CONSTEXPR uint8_t RTC_Hours12(uint8_t hours)
+{
+  return (uint8_t)(((hours + 11U) % 12U) + 1U);
+}
+
+/**
+  * @brief Get the calendar date and time from a number of seconds since 1st January 2000
+  * @note  Only valid for the RTC range (2000-2099): fits in 32bit, no 64bit division.
+  * @param y2kSeconds: number of seconds since 1st January 2000, 00:00:00
+  * @retval calendar date and time (hours: 0-23)
+  */
+RTC_CONSTEXPR civilTime_t RTC_CivilFromY2k(uint32_t y2kSeconds)
+{
+  civilTime_t civil = {0, 0, 0, 0, 0, 0, 0};
+  uint32_t days = y2kSeconds / 86400U;
+  uint32_t secs = y2kSeconds - (days * 86400U);
+  /* Each 4 years cycle (1461 days) starts with a leap year in the RTC range */
+  uint32_t cycleDays = days % 1461U;
+  bool leap = (cycleDays < 366U);
+  uint32_t yday = (leap) ? cycleDays : ((cycleDays - 1U) % 365U);
+  uint8_t month = 12;
+
+  civil.hours = (uint8_t)(secs / 3600U);
+  civil.minutes = (uint8_t)((secs / 60U) % 60U);
+  civil.seconds = (uint8_t)(secs % 60U);
+  /* 1st January 2000 is a saturday (0: sunday) */
+  civil.wday = (uint8_t)((days + 6U) % 7U);
+  if (civil.wday == 0) {
+    civil.wday = 7;
+  }
+
+  civil.year = (uint8_t)(((days / 1461U) * 4U) + ((leap) ? 0U : ((cycleDays - 1U) / 365U)));
+  while ((month > 1) && (yday < RTC_DaysBeforeMonth(month, leap))) {
+    month--;
+  }
+  civil.month = month;
+  civil.day = (uint8_t)(yday - RTC_DaysBeforeMonth(month, leap) + 1U);
+  return civil;
+}
+
+/**
+  * @brief Get the first second of a day matching an alarm, from a given second
+  * @param from: first second of the day to check: 0-86399
+  * @param hours: 0-23
+  * @param minutes: 0-59
+  * @param seconds: 0-59
+  * @param mask: fields compared, bit 0: seconds, 1: minutes, 2: hours
+  * @retval second of the day: 0-86399, 86400 if none
+  */
+RTC_CONSTEXPR uint32_t RTC_AlarmNextInDay(uint32_t from, uint8_t hours, uint8_t minutes, uint8_t seconds,
+                                          uint8_t mask)
+{
+  uint32_t next = 86400U;
+
+  for (uint32_t h = from / 3600U; (next == 86400U) && (h < 24U); h++) {
+    if (((mask & 4U) != 0U) && (h != hours)) {
+      continue;
+    }
+    bool firstHour = (h == (from / 3600U));
+    for (uint32_t m = (firstHour) ? ((from / 60U) % 60U) : 0U; (next == 86400U) && (m < 60U); m++) {
+      if (((mask & 2U) != 0U) && (m != minutes)) {
+        continue;
+      }
+      uint32_t first = (firstHour && (m == ((from / 60U) % 60U))) ? (from % 60U) : 0U;
+      uint32_t s = ((mask & 1U) != 0U) ? seconds : first;
+      if ((s >= first) && (s < 60U)) {
+        next = (h * 3600U) + (m * 60U) + s;
+      }
+    }
+  }
+  return next;
+}
+
+/**
+  * @brief Check if an alarm matches a second between two times, both excluded
+  * @param from: nb of seconds since 1st January 2000
+  * @param to: nb of seconds since 1st January 2000
+  * @param day: 1-31 day of the month
+  * @param hours: 0-23
+  * @param minutes: 0-59
+  * @param seconds: 0-59
+  * @param mask: fields compared, bit 0: seconds, 1: minutes, 2: hours, 3: day
+  * @retval true if the alarm matches between from and to
+  */
+RTC_CONSTEXPR bool RTC_AlarmDue(uint32_t from, uint32_t to, uint8_t day, uint8_t hours, uint8_t minutes,
+                                uint8_t seconds, uint8_t mask)
+{
+  bool due = false;
+  uint32_t t = from + 1U;
+
+  while (!due && (t < to)) {
+    uint32_t dayStart = (t / 86400U) * 86400U;
+    if (((mask & 8U) == 0U) || (RTC_CivilFromY2k(t).day == day)) {
+      uint32_t next = RTC_AlarmNextInDay(t - dayStart, hours, minutes, seconds, mask);
+      due = (next < 86400U) && ((dayStart + next) < to);
+    }
+    t = dayStart + 86400U;
+  }
+  return due;
+}
+
+/**
+  * @brief Divide using a precomputed Q32 reciprocal
+  * @note  recip = UINT32_MAX / d, so the estimated quotient is the exact one
+  *        or one less, fixed by the remainder check.
+  * @param n: dividend
+  * @param d: divisor
+  * @param recip: Q32 reciprocal of the divisor
+  * @retval n / d
+  */
+RTC_CONSTEXPR uint32_t RTC_divRecip(uint32_t n, uint32_t d, uint32_t recip)
+{
+  uint32_t q = (uint32_t)(((uint64_t)n * recip) >> 32);
+  if ((n - (q * d)) >= d) {
+    q++;
+  }
+  return q;
+}
+
+/**
+  * @brief Convert a nb of milliseconds in nb of ticks
+  * @param ms: nb of milliseconds
+  * @param ticksPerSecond: nb of ticks per second (predivSync + 1)
+  * @retval (ms * ticksPerSecond) / 1000
+  */
+RTC_CONSTEXPR uint64_t RTC_MsToTicks(uint64_t ms, uint32_t ticksPerSecond)
+{
+  uint64_t ticks = 0;
+  if (ms <= UINT32_MAX) {
+    /* x / 1000 is (x * 274877907) >> 38 for any 32bit x */
+    uint32_t sec = (uint32_t)(((uint64_t)ms * 274877907U) >> 38);
+    uint32_t rem = (uint32_t)ms - (sec * 1000);
+    ticks = ((uint64_t)sec * ticksPerSecond)
+            + (uint32_t)(((uint64_t)(rem * ticksPerSecond) * 274877907U) >> 38);
+  } else {
+    ticks = (ms * (uint64_t)ticksPerSecond) / (uint64_t)1000;
+  }
+  return ticks;
+}
+
+/**
+  * @brief Find the asynchronous prescaler giving a 1Hz calendar clock, the
+  *        highest one (lowest power) if several. See AN4759.
+  * @param clock: RTC clock frequency in Hz
+  * @param asynchMax: highest asynchronous prescaler value
+  * @param synchMax: highest synchronous prescaler value
+  * @retval asynchronous prescaler value, asynchMax if no 1Hz is possible
+  */
+RTC_CONSTEXPR uint32_t RTC_ComputePredivA(uint32_t clock, uint32_t asynchMax, uint32_t synchMax)
+{
+  uint32_t asynch = asynchMax + 1U;
+  uint32_t synch = 0;
+
+  do {
+    asynch--;
+    synch = (clock / (asynch + 1U)) - 1U;
+  } while ((((synch + 1U) * (asynch + 1U)) != clock) && (asynch != 0U));
+  /* No 1Hz: the lowest power with the highest asynchronous prescaler */
+  return (synch <= synchMax) ? asynch : asynchMax;
+}
+
+/**
+  * @brief Get the BCD calendar increment of the MIX mode: the calendar is
+  *        incremented each 2^(8 + BCDU) SubSecond ticks
+  * @param ticksPerSecond: SubSecond ticks per second (ck_apre frequency)
+  * @retval BCDU value (0-7), 0xFF if no increment is possible
+  */
+RTC_CONSTEXPR uint32_t RTC_BinMixBcdU(uint32_t ticksPerSecond)
+{
+  uint32_t bcdu = (ticksPerSecond <= 256U) ? 0U : 1U;
+
+  while ((bcdu != 0U) && (bcdu < 8U) && (ticksPerSecond >= (256UL << bcdu))) {
+    bcdu++;
+  }
+  return (bcdu < 8U) ? bcdu : 0xFFU;
+}
+
+/**
+  * @brief Get a clock frequency from the duration of a number of SubSecond ticks
+  * @param nbTicks: nb of SubSecond ticks measured
+  * @param asynch: asynchronous prescaler value
+  * @param us: duration of the ticks in microseconds, not 0
+  * @retval clock frequency in Hz, rounded to the nearest
+  */
+RTC_CONSTEXPR uint32_t RTC_ClockFromMeasure(uint32_t nbTicks, uint32_t asynch, uint32_t us)
+{
+  return (uint32_t)((((uint64_t)nbTicks * (asynch + 1U) * 1000000U) + (us / 2U)) / us);
+}
+
+/**
+  * @brief Hash a configuration (FNV-1a on 32bit words)
+  * @param config: configuration words
+  * @param nb: nb of words
+  * @retval hash value, never 0 (value of a cleared backup register)
+  */
+RTC_CONSTEXPR uint32_t RTC_HashConfig(const uint32_t *config, uint32_t nb)
+{
+  uint32_t hash = 2166136261U;
+
+  for (uint32_t i = 0; i < nb; i++) {
+    hash = (hash ^ config[i]) * 16777619U;
+  }
+  return (hash != 0U) ? hash : 1U;
+}
+
+/**
+  * @brief Get the SUBFS value of a shift of the SubSecond register
+  * @note  SUBFS delays the calendar: an advance adds one second (ADD1S)
+  *        and delays of its complement.
+  * @param ticks: nb of ticks to advance (> 0) or delay (< 0) the calendar,
+  *        lower than one second
+  * @param ticksPerSecond: predivSync + 1
+  * @retval SUBFS value
+  */
+RTC_CONSTEXPR uint32_t RTC_ShiftSubFs(int32_t ticks, uint32_t ticksPerSecond)
+{
+  return (ticks > 0) ? (ticksPerSecond - (uint32_t)ticks) : (uint32_t)(-(int64_t)ticks);
+}
+
+/**
+  * @brief Get the calibration pulses needed to slew an offset over a window
+  * @param nbTicks: offset in SubSecond ticks
+  * @param window: duration of the correction in seconds
+  * @param ticksPerSecond: predivSync + 1
+  * @retval nb of pulses per 2^20 RTCCLK cycles, rounded up, saturated to 1024
+  */
+RTC_CONSTEXPR uint32_t RTC_SlewPulses(uint64_t nbTicks, uint32_t window, uint32_t ticksPerSecond)
+{
+  uint64_t rate = (uint64_t)window * ticksPerSecond;
+  uint64_t pulses = ((nbTicks << 20) + rate - 1U) / rate;
+  return (pulses > 1024U) ? 1024U : (uint32_t)pulses;
+}
+
+/**
+  * @brief Get the duration of a slew at a given calibration rate
+  * @param nbTicks: offset in SubSecond ticks
+  * @param nbPulses: calibration pulses of the slew per 2^20 RTCCLK cycles
+  * @param ticksPerSecond: predivSync + 1
+  * @retval nb of seconds, rounded down, saturated to UINT32_MAX, 0 if no pulse
+  */
+RTC_CONSTEXPR uint32_t RTC_SlewSeconds(uint64_t nbTicks, uint32_t nbPulses, uint32_t ticksPerSecond)
+{
+  uint64_t seconds = (nbPulses != 0U) ? ((nbTicks << 20) / ((uint64_t)nbPulses * ticksPerSecond)) : 0U;
+  return (seconds > UINT32_MAX) ? UINT32_MAX : (uint32_t)seconds;
+}
+
+/**
+  * @brief Get the offset corrected by a slew
+  * @param nbPulses: calibration pulses of the slew per 2^20 RTCCLK cycles
+  * @param seconds: duration of the slew
+  * @param ticksPerSecond: predivSync + 1
+  * @retval nb of SubSecond ticks
+  */
+RTC_CONSTEXPR uint64_t RTC_SlewTicks(uint32_t nbPulses, uint32_t seconds, uint32_t ticksPerSecond)
+{
+  return ((uint64_t)nbPulses * seconds * ticksPerSecond) >> 20;
+}
+
+/**
+  * @brief Convert a correction in parts per billion into calibration pulses
+  * @param ppb: correction in parts per billion
+  * @retval nb of pulses per 2^20 RTCCLK cycles, rounded to the nearest
+  */
+RTC_CONSTEXPR int64_t RTC_PulsesFromPpb(int32_t ppb)
+{
+  return (((int64_t)ppb * (1LL << 20)) + ((ppb < 0) ? -500000000LL : 500000000LL)) / 1000000000LL;
+}
+
+/**
+  * @brief Convert calibration pulses into a correction in parts per billion
+  * @param pulses: nb of pulses per 2^20 RTCCLK cycles
+  * @retval correction in parts per billion, rounded to the nearest
+  */
+RTC_CONSTEXPR int32_t RTC_PpbFromPulses(int32_t pulses)
+{
+  return (int32_t)((((int64_t)pulses * 1000000000LL) + ((pulses < 0) ? -(1LL << 19) : (1LL << 19))) / (1LL << 20));
+}
+
+/**
+  * @brief Update a drift estimate with a measure (weighted least squares,
+  *        each measure is weighted by its duration)
+  * @param estimate: drift estimate to update
+  * @param errorMs: RTC time minus the trusted time in milliseconds
+  * @param interval: duration of the measure in seconds
+  * @param calibPpb: calibration applied during the measure
+  * @param limits: limits of the drift learning
+  * @retval true if the estimate is updated, false if the measure is rejected
+  */
+RTC_CONSTEXPR bool RTC_DriftUpdate(driftEstimate_t *estimate, int64_t errorMs, uint32_t interval,
+                                   int32_t calibPpb, driftLimits_t limits)
+{
+  /* Crystal drift: RTC rate error without the applied calibration */
+  int64_t sample = (interval != 0U) ? (((errorMs * 1000000LL) / interval) - calibPpb) : 0;
+  int64_t measureWeight = interval / 60U;
+
+  if ((interval == 0U) || (interval < limits.minInterval)) {
+    return false;
+  }
+  if ((sample > 1000000LL) || (sample < -1000000LL)) {
+    /* Wrong reference, more than 1000 ppm */
+    return false;
+  }
+  if ((estimate->weight != 0U) && (((sample - estimate->ppb) > limits.outlierPpb)
+                                   || ((estimate->ppb - sample) > limits.outlierPpb))) {
+    if (++estimate->outliers < limits.maxOutliers) {
+      return false;
+    }
+    /* Persistent change of the drift: learn again */
+    estimate->weight = 0;
+  }
+  estimate->outliers = 0;
+  estimate->ppb = (int32_t)((((int64_t)estimate->ppb * estimate->weight) + (sample * measureWeight))
+                            / (estimate->weight + measureWeight));
+  measureWeight += estimate->weight;
+  estimate->weight = (uint16_t)((measureWeight < limits.window) ? measureWeight : limits.window);
+  return true;
+}
+
+/**
+  * @brief Get the nb of ticks at a frequency for a nb of ticks at another one,
+  *        split in seconds first so that it only overflows if the result does
+  * @param ticks: nb of ticks at freq
+  * @param freq: frequency of the ticks
+  * @param hz: frequency of the result
+  * @retval nb of ticks at hz, rounded down
+  */
+RTC_CONSTEXPR uint64_t RTC_ScaleTicks(uint64_t ticks, uint32_t freq, uint32_t hz)
+{
+  return (freq == hz) ? ticks : (((ticks / freq) * hz) + (((ticks % freq) * hz) / freq));
+}
+
+#endif /* __RTC_MATH_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,66 @@
+/**
+  ******************************************************************************
+  * @file    rtc_math_c.c
+  * @brief   Build of rtc_math.h as C, the inline functions are checked
+  *          against a few vectors of rtc_math_test.cpp.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; COPYRIGHT(c) 2020 STMicroelectronics</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without modification,
+  * are permitted provided that the following conditions are met:
+  *   1. Redistributions of source code must retain the above copyright notice,
+  *      this list of conditions and the following disclaimer.
+  *   2. Redistributions in binary form must reproduce the above copyright notice,
+  *      this list of conditions and the following disclaimer in the documentation
+  *      and/or other materials provided with the distribution.
+  *   3. Neither the name of STMicroelectronics nor the names of its contributors
+  *      may be used to endorse or promote products derived from this software
+  *      without specific prior written permission.
+  *
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+#include "rtc_math.h"
+
+/**
+  * @brief  check the C build of rtc_math.h
+  * @retval nb of failed checks
+  */
+int rtc_math_c_check(void)
+{
+  static const uint32_t hashConfig[2] = {1, 2};
+  driftEstimate_t estimate = {0, 0, 0};
+  const driftLimits_t limits = {3600, 10000, 3, 43200};
+  civilTime_t civil = RTC_CivilFromY2k(RTC_Y2kSeconds(24, 2, 29, 13, 5, 7));
+  int nbFailures = 0;
+
+  nbFailures += (RTC_Bcd2Bin(RTC_PackTime(21, 7, 45, false)) != 0x0015072D);
+  nbFailures += (RTC_PackDate(0, 1, 1, 6) != 0x0000C101);
+  nbFailures += ((civil.year != 24) || (civil.month != 2) || (civil.day != 29) || (civil.wday != 4)
+                 || (civil.hours != 13) || (civil.minutes != 5) || (civil.seconds != 7));
+  nbFailures += (RTC_SsrToTicks(255, 100 + RTC_ShiftSubFs(-200, 256)) != 211);
+  nbFailures += (RTC_MsToTicks(UINT32_MAX, 32768) != 140737488322ULL);
+  nbFailures += (RTC_ComputePredivA(40000, 127, 32767) != 124);
+  nbFailures += (RTC_BinMixBcdU(32768) != 0xFF);
+  nbFailures += (RTC_HashConfig(hashConfig, 2) != 3983810698U);
+  nbFailures += (RTC_SlewSeconds(100, 114, 256) != 3592);
+  nbFailures += (RTC_PulsesFromPpb(RTC_PpbFromPulses(-511)) != -511);
+  nbFailures += !RTC_AlarmDue(RTC_Y2kSeconds(1, 1, 31, 12, 0, 0), RTC_Y2kSeconds(1, 3, 31, 12, 0, 1), 31, 12, 0, 0, 15);
+  nbFailures += (RTC_ScaleTicks(UINT64_MAX, 32768, 1000) != 562949953421311999ULL);
+  nbFailures += !RTC_DriftUpdate(&estimate, 36, 3600, 0, limits);
+  nbFailures += !RTC_DriftUpdate(&estimate, 108, 7200, 0, limits);
+  nbFailures += (estimate.ppb != 13333);
+  return nbFailures;
+}
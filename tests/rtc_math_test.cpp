@@ -0,0 +1,379 @@
+/**
+  ******************************************************************************
+  * @file    rtc_math_test.cpp
+  * @brief   Host tests of the RTC driver computations (rtc_math.h): the
+  *          vectors are checked at build time, the ranges when running.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; COPYRIGHT(c) 2020 STMicroelectronics</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without modification,
+  * are permitted provided that the following conditions are met:
+  *   1. Redistributions of source code must retain the above copyright notice,
+  *      this list of conditions and the following disclaimer.
+  *   2. Redistributions in binary form must reproduce the above copyright notice,
+  *      this list of conditions and the following disclaimer in the documentation
+  *      and/or other materials provided with the distribution.
+  *   3. Neither the name of STMicroelectronics nor the names of its contributors
+  *      may be used to endorse or promote products derived from this software
+  *      without specific prior written permission.
+  *
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+#include <cstdio>
+
+#include "rtc_math.h"
+
+#define EPOCH_TIME_OFF      946684800  // This is 1st January 2000, 00:00:00 in epoch time
+#define EPOCH_TIME_MAX      4102444799 // This is 31st December 2099, 23:59:59 in epoch time
+#define Y2K_SECONDS_MAX     3155759999U // This is 31st December 2099, 23:59:59 since 1st January 2000
+
+extern "C" int rtc_math_c_check(void);
+
+static int nbFailures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      nbFailures++; \
+    } \
+  } while (0)
+
+// Register BCD fields converted at once by the direct register reads
+static_assert(RTC_Bcd2Bin(0) == 0, "Wrong BCD conversion");
+static_assert(RTC_Bcd2Bin(0x00235959) == 0x00173B3B, "Wrong BCD conversion");
+static_assert(RTC_Bcd2Bin(0x00991231) == 0x00630C1F, "Wrong BCD conversion");
+static_assert(RTC_Bcd2Bin(0x99999999) == 0x63636363, "Wrong BCD conversion");
+
+// Time and date registers written at once by RTC_SetDateTime()
+static_assert(RTC_Bin2Bcd(0) == 0x00, "Wrong BCD conversion");
+static_assert(RTC_Bin2Bcd(59) == 0x59, "Wrong BCD conversion");
+static_assert(RTC_Bin2Bcd(99) == 0x99, "Wrong BCD conversion");
+static_assert(RTC_PackTime(23, 59, 59, false) == 0x00235959, "Wrong time register packing");
+static_assert(RTC_PackTime(12, 0, 7, true) == 0x00520007, "Wrong time register packing");
+static_assert(RTC_PackDate(99, 12, 31, 4) == 0x00999231, "Wrong date register packing");
+static_assert(RTC_PackDate(0, 1, 1, 6) == 0x0000C101, "Wrong date register packing");
+static_assert(RTC_Bcd2Bin(RTC_PackTime(21, 7, 45, false)) == 0x0015072D, "Wrong time register round trip");
+
+// Second rollover between the SubSecond register reads of getDateTime()
+static_assert(!RTC_SecondRollover(false, 255, 200, 150), "Wrong BCD rollover detection");
+static_assert(RTC_SecondRollover(false, 255, 3, 250), "Wrong BCD rollover detection");
+static_assert(!RTC_SecondRollover(true, 0xFF, 0xFFFFFF80, 0xFFFFFF10), "Wrong MIX rollover detection");
+static_assert(RTC_SecondRollover(true, 0xFF, 0xFFFFFF00, 0xFFFFFEFF), "Wrong MIX rollover detection");
+
+// SubSecond register above PREDIV_S after a shift, the calendar is one second ahead
+static_assert(RTC_SsrToTicks(255, 255) == 0, "Wrong SubSecond ticks");
+static_assert(RTC_SsrToTicks(255, 0) == 255, "Wrong SubSecond ticks");
+static_assert(!RTC_SecondAhead(255, 255), "Wrong second ahead detection");
+// 250ms phase set at the start of a second: ADD1S and SUBFS of 192 ticks
+static_assert(RTC_SecondAhead(255, 255 + RTC_ShiftSubFs(64, 256)), "Wrong second ahead detection");
+static_assert(RTC_SsrToTicks(255, 255 + RTC_ShiftSubFs(64, 256)) == 64, "Wrong SubSecond ticks");
+// 200 ticks delay 155 ticks after the start of a second: 45 ticks before it
+static_assert(RTC_SsrToTicks(255, 100 + RTC_ShiftSubFs(-200, 256)) == 211, "Wrong SubSecond ticks");
+static_assert(RTC_SsrToTicks(32767, 65534) == 1, "Wrong SubSecond ticks");
+
+// Days and seconds since 1st January 2000
+static_assert(RTC_DaysBeforeMonth(3, false) == 59, "Wrong days before month");
+static_assert(RTC_DaysBeforeMonth(3, true) == 60, "Wrong days before month");
+static_assert(RTC_DaysBeforeMonth(8, false) == 212, "Wrong days before month");
+static_assert(RTC_DaysBeforeMonth(12, true) == 335, "Wrong days before month");
+static_assert(RTC_DaysFromCivil(0, 2, 29) == 59, "Wrong days conversion");
+static_assert(RTC_DaysFromCivil(1, 1, 1) == 366, "Wrong days conversion");
+static_assert(RTC_DaysFromCivil(1, 3, 1) == 425, "Wrong days conversion");
+static_assert(RTC_DaysFromCivil(99, 12, 31) == 36524, "Wrong days conversion");
+static_assert(RTC_Y2kSeconds(0, 1, 1, 0, 0, 0) == 0, "Wrong calendar conversion");
+static_assert(EPOCH_TIME_OFF + RTC_Y2kSeconds(24, 2, 29, 12, 0, 0) == 1709208000, "Wrong calendar conversion");
+static_assert(EPOCH_TIME_OFF + RTC_Y2kSeconds(99, 12, 31, 23, 59, 59) == EPOCH_TIME_MAX, "Wrong calendar conversion");
+static_assert(RTC_Y2kSeconds(99, 12, 31, 23, 59, 59) == Y2K_SECONDS_MAX, "Wrong calendar conversion");
+
+/**
+  * @brief  check a calendar date and time split from a number of seconds
+  * @retval true if RTC_CivilFromY2k() gives the expected values
+  */
+static constexpr bool civilIs(uint32_t y2kSeconds, uint8_t year, uint8_t month, uint8_t day, uint8_t wday,
+                              uint8_t hours, uint8_t minutes, uint8_t seconds)
+{
+  const civilTime_t civil = RTC_CivilFromY2k(y2kSeconds);
+
+  return (civil.year == year) && (civil.month == month) && (civil.day == day) && (civil.wday == wday)
+         && (civil.hours == hours) && (civil.minutes == minutes) && (civil.seconds == seconds);
+}
+
+// Round trip across the leap days and the bounds of the RTC range
+static_assert(civilIs(0, 0, 1, 1, 6, 0, 0, 0), "Wrong calendar conversion");
+static_assert(civilIs(RTC_Y2kSeconds(0, 2, 29, 12, 0, 0), 0, 2, 29, 2, 12, 0, 0), "Wrong calendar conversion");
+static_assert(civilIs(RTC_Y2kSeconds(1, 3, 1, 8, 30, 15), 1, 3, 1, 4, 8, 30, 15), "Wrong calendar conversion");
+static_assert(civilIs(RTC_Y2kSeconds(20, 12, 31, 23, 0, 1), 20, 12, 31, 4, 23, 0, 1), "Wrong calendar conversion");
+static_assert(civilIs(RTC_Y2kSeconds(23, 12, 31, 6, 7, 8), 23, 12, 31, 7, 6, 7, 8), "Wrong calendar conversion");
+static_assert(civilIs(1709208000 - EPOCH_TIME_OFF, 24, 2, 29, 4, 12, 0, 0), "Wrong calendar conversion");
+static_assert(civilIs(Y2K_SECONDS_MAX, 99, 12, 31, 4, 23, 59, 59), "Wrong calendar conversion");
+static_assert(civilIs(RTC_Y2kSeconds(24, 2, 29, 13, 5, 7), 24, 2, 29, 4, 13, 5, 7), "Wrong calendar conversion");
+
+// 12 hours format: 12 AM is midnight, 12 PM is noon
+static_assert(RTC_Hours24(12, false) == 0, "Wrong 12 hours conversion");
+static_assert(RTC_Hours24(11, false) == 11, "Wrong 12 hours conversion");
+static_assert(RTC_Hours24(12, true) == 12, "Wrong 12 hours conversion");
+static_assert(RTC_Hours24(1, true) == 13, "Wrong 12 hours conversion");
+static_assert(RTC_Hours12(0) == 12, "Wrong 12 hours conversion");
+static_assert(RTC_Hours12(12) == 12, "Wrong 12 hours conversion");
+static_assert(RTC_Hours12(13) == 1, "Wrong 12 hours conversion");
+static_assert(RTC_Hours12(23) == 11, "Wrong 12 hours conversion");
+
+// Division-free SubSecond conversions
+static_assert(RTC_divRecip(255 * 1000, 256, UINT32_MAX / 256) == 996, "Wrong reciprocal division");
+static_assert(RTC_divRecip(999000, 1000, UINT32_MAX / 1000) == 999, "Wrong reciprocal division");
+static_assert(RTC_divRecip(UINT32_MAX, 1, UINT32_MAX) == UINT32_MAX, "Wrong reciprocal division");
+static_assert(RTC_divRecip(UINT32_MAX, 32768, UINT32_MAX / 32768) == 131071, "Wrong reciprocal division");
+static_assert(RTC_MsToTicks(500, 256) == 128, "Wrong milliseconds conversion");
+static_assert(RTC_MsToTicks(999, 256) == 255, "Wrong milliseconds conversion");
+static_assert(RTC_MsToTicks(UINT32_MAX, 32768) == 140737488322, "Wrong milliseconds conversion");
+static_assert(RTC_MsToTicks(1ULL << 40, 1000) == (1ULL << 40), "Wrong milliseconds conversion");
+
+// Prescalers of the 1Hz calendar clock and measure of the RTC clock
+static_assert(RTC_ComputePredivA(32768, 127, 32767) == 127, "Wrong asynchronous prescaler");
+static_assert(RTC_ComputePredivA(40000, 127, 32767) == 124, "Wrong asynchronous prescaler");
+static_assert(RTC_ComputePredivA(37000, 127, 32767) == 124, "Wrong asynchronous prescaler");
+static_assert(RTC_ComputePredivA(32771, 127, 32767) == 127, "Wrong asynchronous prescaler without 1Hz");
+static_assert(RTC_ComputePredivA(1000000, 127, 8191) == 124, "Wrong asynchronous prescaler");
+static_assert(RTC_ClockFromMeasure(8, 127, 31250) == 32768, "Wrong clock measure");
+static_assert(RTC_ClockFromMeasure(8, 127, 31251) == 32767, "Wrong clock measure rounding");
+static_assert(RTC_ClockFromMeasure(8, 124, 25001) == 39998, "Wrong clock measure rounding");
+
+// BCD calendar increment of the MIX mode: each 2^(8 + BCDU) SubSecond ticks
+static_assert(RTC_BinMixBcdU(256) == 0, "Wrong MIX mode BCD increment");
+static_assert(RTC_BinMixBcdU(257) == 1, "Wrong MIX mode BCD increment");
+static_assert(RTC_BinMixBcdU(512) == 2, "Wrong MIX mode BCD increment");
+static_assert(RTC_BinMixBcdU(32767) == 7, "Wrong MIX mode BCD increment");
+static_assert(RTC_BinMixBcdU(32768) == 0xFF, "Wrong MIX mode BCD increment");
+
+// Hash of the configuration fingerprint: order dependent, never the cleared register value
+static constexpr uint32_t hashConfig12[2] = {1, 2};
+static constexpr uint32_t hashConfig21[2] = {2, 1};
+static constexpr uint32_t hashConfigZero[1] = {2166136261U};
+static_assert(RTC_HashConfig(hashConfig12, 0) == 2166136261U, "Wrong configuration hash");
+static_assert(RTC_HashConfig(hashConfig12, 2) == 3983810698U, "Wrong configuration hash");
+static_assert(RTC_HashConfig(hashConfig21, 2) == 1551600396U, "Wrong configuration hash");
+static_assert(RTC_HashConfig(hashConfigZero, 1) == 1, "Configuration hash must not be 0");
+
+// Alarms due while the calendar is carried forward, both times excluded
+static_assert(RTC_AlarmNextInDay(0, 8, 0, 0, 7) == 28800, "Wrong next alarm");
+static_assert(RTC_AlarmNextInDay(28801, 8, 0, 0, 7) == 86400, "Wrong next alarm");
+static_assert(RTC_AlarmNextInDay(28801, 8, 0, 0, 4) == 28801, "Wrong next alarm");
+static_assert(RTC_AlarmNextInDay(3599, 0, 30, 15, 3) == 5415, "Wrong next alarm");
+static_assert(RTC_AlarmNextInDay(86399, 0, 0, 0, 0) == 86399, "Wrong next alarm");
+static_assert(RTC_AlarmDue(RTC_Y2kSeconds(1, 1, 1, 7, 59, 58), RTC_Y2kSeconds(1, 1, 1, 8, 0, 2), 1, 8, 0, 0, 7),
+              "Daily alarm must be due");
+static_assert(!RTC_AlarmDue(RTC_Y2kSeconds(1, 1, 1, 8, 0, 0), RTC_Y2kSeconds(1, 1, 1, 8, 0, 5), 1, 8, 0, 0, 7),
+              "Alarm at the start must not be due");
+static_assert(!RTC_AlarmDue(RTC_Y2kSeconds(1, 1, 1, 7, 59, 58), RTC_Y2kSeconds(1, 1, 1, 8, 0, 0), 1, 8, 0, 0, 7),
+              "Alarm at the end must not be due");
+static_assert(RTC_AlarmDue(10, 12, 1, 0, 0, 0, 0), "Alarm each second must be due");
+static_assert(!RTC_AlarmDue(10, 11, 1, 0, 0, 0, 0), "Alarm without second between must not be due");
+static_assert(!RTC_AlarmDue(RTC_Y2kSeconds(1, 1, 31, 12, 0, 0), RTC_Y2kSeconds(1, 3, 30, 12, 0, 0), 31, 12, 0, 0, 15),
+              "Alarm on the 31st must not be due in February");
+static_assert(RTC_AlarmDue(RTC_Y2kSeconds(1, 1, 31, 12, 0, 0), RTC_Y2kSeconds(1, 3, 31, 12, 0, 1), 31, 12, 0, 0, 15),
+              "Alarm on the 31st must be due in March");
+
+// Tick scaling of STM32RTC::basic_steady_clock
+static_assert(RTC_ScaleTicks(12345, 250, 250) == 12345, "Wrong tick scaling");
+static_assert(RTC_ScaleTicks(1000, 256, 1000) == 3906, "Wrong tick scaling");
+static_assert(RTC_ScaleTicks(255, 256, 1000) == 996, "Wrong tick scaling");
+static_assert(RTC_ScaleTicks((3 * 32768) + 16384, 32768, 250) == 875, "Wrong tick scaling");
+static_assert(RTC_ScaleTicks(UINT64_MAX, 32768, 1000) == 562949953421311999ULL, "Wrong tick scaling");
+
+// SubSecond register shifts, one second added for an advance
+static_assert(RTC_ShiftSubFs(10, 256) == 246, "Wrong shift");
+static_assert(RTC_ShiftSubFs(-10, 256) == 10, "Wrong shift");
+static_assert(RTC_ShiftSubFs(255, 256) == 1, "Wrong shift");
+static_assert(RTC_ShiftSubFs(-255, 256) == 255, "Wrong shift");
+static_assert(RTC_ShiftSubFs(1, 32768) == 32767, "Wrong shift");
+static_assert(RTC_ShiftSubFs((int32_t)RTC_MsToTicks(250, 256), 256) == 192, "Wrong shift");
+
+// Time slew: the calibration corrects the offset but the remainder, lower than one second
+static_assert(RTC_SlewPulses(100, 3600, 256) == 114, "Wrong slew rate");
+static_assert(RTC_SlewSeconds(100, 114, 256) == 3592, "Wrong slew duration");
+static_assert(RTC_SlewTicks(114, 3592, 256) == 99, "Wrong slew correction");
+static_assert(RTC_SlewPulses(2560, 3600, 256) == 1024, "Slew rate must saturate");
+static_assert(RTC_SlewSeconds(2560, 512, 256) == 20480, "Wrong slew duration");
+static_assert(RTC_SlewTicks(512, 20480, 256) == 2560, "Wrong slew correction");
+static_assert(RTC_SlewSeconds((32768ULL * 5) + 7, 512, 32768) == 10240, "Wrong slew duration");
+static_assert(RTC_SlewTicks(512, 10240, 32768) == 32768 * 5, "Wrong slew correction");
+static_assert(RTC_SlewSeconds(INT32_MAX, 1, 1) == UINT32_MAX, "Slew duration must saturate");
+static_assert(RTC_SlewSeconds(100, 0, 256) == 0, "No slew without calibration pulses");
+
+// Calibration rounding, both ways and at the bounds of the range
+static_assert(RTC_PulsesFromPpb(476) == 0, "Wrong calibration rounding");
+static_assert(RTC_PulsesFromPpb(477) == 1, "Wrong calibration rounding");
+static_assert(RTC_PulsesFromPpb(-954) == -1, "Wrong calibration rounding");
+static_assert(RTC_PulsesFromPpb(488281) == 512, "Wrong calibration rounding");
+static_assert(RTC_PulsesFromPpb(-487325) == -511, "Wrong calibration rounding");
+static_assert(RTC_PpbFromPulses(1) == 954, "Wrong calibration rounding");
+static_assert(RTC_PpbFromPulses(-1) == -954, "Wrong calibration rounding");
+static_assert(RTC_PpbFromPulses(512) == 488281, "Wrong calibration rounding");
+static_assert(RTC_PulsesFromPpb(RTC_PpbFromPulses(-511)) == -511, "Wrong calibration round trip");
+
+// Default limits of the drift learning (STM32RTC.h)
+static constexpr driftLimits_t driftLimits = {3600, 10000, 3, 43200};
+
+/**
+  * @brief  check the drift estimate after two measures
+  * @retval estimated drift in ppb, INT32_MIN if a measure is rejected
+  */
+static constexpr int32_t driftAfter(int64_t errorMs1, uint32_t interval1, int64_t errorMs2, uint32_t interval2)
+{
+  driftEstimate_t estimate = {0, 0, 0};
+  return (RTC_DriftUpdate(&estimate, errorMs1, interval1, 0, driftLimits)
+          && RTC_DriftUpdate(&estimate, errorMs2, interval2, 0, driftLimits)) ? estimate.ppb : INT32_MIN;
+}
+
+// Drift learning: weighted mean of the measures, too short or wrong measures rejected
+static_assert(driftAfter(36, 3600, 72, 7200) == 10000, "Wrong drift estimate");
+static_assert(driftAfter(36, 3600, 108, 7200) == 13333, "Wrong weighted drift estimate");
+static_assert(driftAfter(36, 3600, -36, 3600) == INT32_MIN, "Drift outlier must be rejected");
+static_assert(driftAfter(36, 3599, 36, 3600) == INT32_MIN, "Short drift measure must be rejected");
+static_assert(driftAfter(3601000, 3600, 36, 3600) == INT32_MIN, "Wrong drift reference must be rejected");
+
+/**
+  * @brief  check each day of the RTC range: calendar round trip and week day
+  * @retval None
+  */
+static void checkCalendarRange(void)
+{
+  uint8_t wday = 6; // 1st January 2000 is a saturday
+
+  for (uint32_t days = 0; days <= (Y2K_SECONDS_MAX / 86400U); days++) {
+    /* One second before midnight, then midnight of the next day */
+    uint32_t y2kSeconds = (days * 86400U) + 86399U;
+    civilTime_t civil = RTC_CivilFromY2k(y2kSeconds);
+
+    CHECK(civil.wday == wday);
+    CHECK((civil.hours == 23) && (civil.minutes == 59) && (civil.seconds == 59));
+    CHECK(RTC_Y2kSeconds(civil.year, civil.month, civil.day, civil.hours, civil.minutes, civil.seconds) == y2kSeconds);
+    if (y2kSeconds < Y2K_SECONDS_MAX) {
+      civilTime_t next = RTC_CivilFromY2k(y2kSeconds + 1U);
+      CHECK((next.hours == 0) && (next.minutes == 0) && (next.seconds == 0));
+      CHECK((next.day == civil.day + 1) || ((next.day == 1) && ((next.month == civil.month + 1)
+                                                                 || ((next.month == 1) && (next.year == civil.year + 1)))));
+    }
+    wday = (wday == 7) ? 1 : (wday + 1);
+  }
+}
+
+/**
+  * @brief  check the SubSecond conversions of the BCD mode over the whole
+  *         register range, after any advance or delay shift
+  * @param  predivS: synchronous prescaler value
+  * @retval None
+  */
+static void checkShiftRange(uint32_t predivS)
+{
+  uint32_t ticksPerSecond = predivS + 1;
+
+  for (uint32_t ssr = 0; ssr <= predivS; ssr++) {
+    uint32_t elapsed = predivS - ssr;
+
+    CHECK(RTC_SsrToTicks(predivS, ssr) == elapsed);
+    for (uint32_t nbTicks = 1; nbTicks < ticksPerSecond; nbTicks++) {
+      /* Delay: the calendar registers are one second ahead if the shift crosses the second */
+      uint32_t delayed = ssr + RTC_ShiftSubFs(-(int32_t)nbTicks, ticksPerSecond);
+      CHECK(RTC_SecondAhead(predivS, delayed) == (nbTicks > elapsed));
+      CHECK(RTC_SsrToTicks(predivS, delayed) == ((elapsed + ticksPerSecond - nbTicks) % ticksPerSecond));
+      /* Advance: one second added (ADD1S), then delayed of the complement */
+      uint32_t advanced = ssr + RTC_ShiftSubFs((int32_t)nbTicks, ticksPerSecond);
+      CHECK(RTC_SecondAhead(predivS, advanced) == ((elapsed + nbTicks) < ticksPerSecond));
+      CHECK(RTC_SsrToTicks(predivS, advanced) == ((elapsed + nbTicks) % ticksPerSecond));
+    }
+  }
+}
+
+/**
+  * @brief  check the due alarms against a check of each second
+  * @param  from: nb of seconds since 1st January 2000
+  * @param  nbSeconds: nb of seconds of the windows checked from there
+  * @retval None
+  */
+static void checkAlarmDue(uint32_t from, uint32_t nbSeconds)
+{
+  static const uint8_t alarms[][5] = {
+    /* day, hours, minutes, seconds, mask */
+    {1, 0, 0, 0, 0}, {1, 0, 0, 30, 1}, {1, 0, 59, 0, 3}, {1, 23, 0, 0, 4},
+    {29, 0, 0, 0, 8}, {31, 23, 59, 59, 15}, {1, 0, 0, 0, 15}, {15, 12, 30, 0, 14}
+  };
+
+  for (const uint8_t *alarm : alarms) {
+    uint32_t last = from + nbSeconds;
+    /* Brute force: next matching second from each start of window */
+    uint32_t next = UINT32_MAX;
+    for (uint32_t t = last; t > from; t--) {
+      civilTime_t civil = RTC_CivilFromY2k(t);
+      if ((((alarm[4] & 8U) == 0U) || (civil.day == alarm[0]))
+          && (((alarm[4] & 4U) == 0U) || (civil.hours == alarm[1]))
+          && (((alarm[4] & 2U) == 0U) || (civil.minutes == alarm[2]))
+          && (((alarm[4] & 1U) == 0U) || (civil.seconds == alarm[3]))) {
+        next = t;
+      }
+      if (next != UINT32_MAX) {
+        /* Due once the window includes the next matching second */
+        CHECK(!RTC_AlarmDue(t - 1U, next, alarm[0], alarm[1], alarm[2], alarm[3], alarm[4]));
+        CHECK(RTC_AlarmDue(t - 1U, next + 1U, alarm[0], alarm[1], alarm[2], alarm[3], alarm[4]));
+      }
+      for (uint32_t to = t + 1U; ((t % 211U) == 0U) && (to <= last); to += 997U) {
+        CHECK(RTC_AlarmDue(t - 1U, to, alarm[0], alarm[1], alarm[2], alarm[3], alarm[4]) == (next < to));
+      }
+    }
+  }
+}
+
+/**
+  * @brief  check the division-free conversions against the divisions
+  * @param  ticksPerSecond: predivSync + 1
+  * @retval None
+  */
+static void checkConversions(uint32_t ticksPerSecond)
+{
+  uint32_t recip = UINT32_MAX / ticksPerSecond;
+
+  for (uint32_t ticks = 0; ticks < ticksPerSecond; ticks++) {
+    CHECK(RTC_divRecip(ticks * 1000U, ticksPerSecond, recip) == ((ticks * 1000U) / ticksPerSecond));
+  }
+  for (uint64_t n = 0; n <= UINT32_MAX; n += 65521U) {
+    CHECK(RTC_divRecip((uint32_t)n, ticksPerSecond, recip) == ((uint32_t)n / ticksPerSecond));
+  }
+  for (uint64_t ms = 0; ms < 100000U; ms++) {
+    CHECK(RTC_MsToTicks(ms, ticksPerSecond) == ((ms * ticksPerSecond) / 1000U));
+  }
+  CHECK(RTC_MsToTicks(UINT32_MAX, ticksPerSecond) == (((uint64_t)UINT32_MAX * ticksPerSecond) / 1000U));
+}
+
+int main(void)
+{
+  checkCalendarRange();
+  checkShiftRange(255);
+  checkShiftRange(1023);
+  checkConversions(256);
+  checkConversions(1024);
+  checkConversions(32768);
+  checkAlarmDue(RTC_Y2kSeconds(4, 2, 27, 23, 0, 0), 4 * 86400);
+  checkAlarmDue(RTC_Y2kSeconds(99, 12, 30, 0, 0, 0), 2 * 86400 - 1);
+  /* Same header built as C, with the inline functions */
+  CHECK(rtc_math_c_check() == 0);
+
+  if (nbFailures != 0) {
+    printf("%d check(s) failed\n", nbFailures);
+    return 1;
+  }
+  printf("rtc_math: all checks passed\n");
+  return 0;
+}